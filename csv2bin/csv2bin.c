@@ -0,0 +1,44 @@
+/*!
+ * \file csv2bin.c
+ * \brief Fichier principale concernant la conversion
+ * d'un fichier de données CSV vers le format binaire
+ * lu directement (mmap) par kmeans, knn, mlp et som.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "data.h"
+
+void usage(char * exec) {
+  fprintf(stderr, "Usage: %s <file>.csv <file>.bin\n", exec);
+  exit(1);
+}
+
+int main(int argc, char *argv[]) {
+  if(argc != 3)
+    usage(argv[0]);
+
+  struct stat st;
+  struct timespec t0, t1;
+  if(stat(argv[1], &st) < 0) {
+    fprintf(stderr, "Can't open file %s\n", argv[1]);
+    exit(1);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+  data_t * data = load_data(argv[1], 0);
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  write_bin(data, argv[2]);
+
+  double secs = (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9;
+  printf("%s: %d x %d, %d labels\n", argv[2], data->n, data->d, data->labels->size);
+  printf("parsed %.1f MB in %.3f s (%.1f MB/s)\n",
+    st.st_size / 1e6, secs, st.st_size / 1e6 / secs);
+
+  free_data(data);
+  return 0;
+}
@@ -0,0 +1,326 @@
+/*!
+ * \file datagen.c
+ * \brief Fichier principale concernant la génération de
+ * datasets synthétiques (blobs gaussiens, uniformes ou à
+ * classes déséquilibrées) au format CSV et/ou binaire, pour
+ * mesurer les performances de kmeans, knn, mlp et som.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "data.h"
+#include "rng.h"
+
+#define GEN_MAX_DIMS 4096     // nombre maximal de valeurs par donnée
+#define GEN_BOX 10.0          // les centres (et les données uniformes) sont dans [-GEN_BOX, GEN_BOX]
+#define GEN_SCALE 10000.0     // les valeurs sont arrondies à 1 / GEN_SCALE
+#define GEN_BUF_SZ (1 << 22)  // taille des tampons d'écriture (octets)
+
+/** \brief Type de dataset généré */
+enum { GEN_BLOBS, GEN_UNIFORM, GEN_IMBALANCED };
+
+/** \brief Structure représentant les paramètres du générateur */
+typedef struct gen gen_t;
+struct gen {
+  int type;          // type de dataset
+  long rows;         // nombre de données
+  int dims;          // nombre de valeurs par donnée
+  int classes;       // nombre de classes
+  uint64_t seed;     // graine
+  double spread;     // écart-type des blobs
+  double * centers;  // centre de chaque classe (classes x dims)
+  double * cdf;      // fonction de répartition des classes
+};
+
+void usage(char * exec) {
+  fprintf(stderr,
+    "Usage: %s [-t blobs|uniform|imbalanced] [-n rows] [-d dims] [-k classes]\n"
+    "          [-s seed] [-r spread] [-o <file>.csv] [-b <file>.bin]\n", exec);
+  exit(1);
+}
+
+/** \brief Initialise l'état aléatoire propre à une clé (classe ou
+ * donnée), afin que chaque donnée soit générée indépendamment de
+ * l'ordre de génération.
+ *
+ * \param seed graine
+ * \param key clé
+ *
+ * \return l'état du générateur
+ */
+static uint64_t key_state(uint64_t seed, uint64_t key) {
+  uint64_t s = seed ^ (key * 0xD1B54A32D192ED03ULL);
+  splitmix64(&s);
+  return s;
+}
+
+/** \brief Tire un réel uniforme dans [0, 1).
+ *
+ * \param s état du générateur
+ */
+static double uniform(uint64_t * s) {
+  return (splitmix64(s) >> 11) * 0x1p-53;
+}
+
+/** \brief Tire un réel selon la loi normale centrée réduite
+ * (Box-Muller).
+ *
+ * \param s état du générateur
+ */
+static double gaussian(uint64_t * s) {
+  double u = 1.0 - uniform(s), v = uniform(s);
+  return sqrt(-2.0 * log(u)) * cos(2.0 * M_PI * v);
+}
+
+/** \brief Initialise les centres des classes et la fonction de
+ * répartition des classes: uniforme, ou de Zipf (la classe c est
+ * tirée avec une probabilité proportionnelle à 1 / (c + 1)^2) pour
+ * les datasets déséquilibrés.
+ *
+ * \param gen paramètres du générateur
+ */
+static void init_gen(gen_t * gen) {
+  int c, j;
+  uint64_t s;
+  double sum = 0;
+
+  gen->centers = (double *)malloc((size_t)gen->classes * gen->dims * sizeof(*gen->centers));
+  assert(gen->centers);
+  gen->cdf = (double *)malloc(gen->classes * sizeof(*gen->cdf));
+  assert(gen->cdf);
+
+  for(c = 0; c < gen->classes; c++) {
+    s = key_state(gen->seed, ~(uint64_t)c);
+    for(j = 0; j < gen->dims; j++)
+      gen->centers[(size_t)c * gen->dims + j] = (2.0 * uniform(&s) - 1.0) * GEN_BOX;
+    sum += gen->type == GEN_IMBALANCED ? 1.0 / ((c + 1.0) * (c + 1.0)) : 1.0;
+    gen->cdf[c] = sum;
+  }
+  for(c = 0; c < gen->classes; c++)
+    gen->cdf[c] /= sum;
+}
+
+/** \brief Tire la classe de la donnée: c'est le premier tirage de
+ * son état aléatoire.
+ *
+ * \param gen paramètres du générateur
+ * \param s état du générateur de la donnée
+ *
+ * \return la classe de la donnée
+ */
+static int draw_class(gen_t * gen, uint64_t * s) {
+  double u = uniform(s);
+  int lo = 0, hi = gen->classes - 1, mid;
+
+  while(lo < hi) {
+    mid = (lo + hi) / 2;
+    if(u < gen->cdf[mid]) hi = mid;
+    else lo = mid + 1;
+  }
+  return lo;
+}
+
+/** \brief Génère la i-ème donnée. Les valeurs sont arrondies à
+ * 1 / GEN_SCALE: q[j] est la valeur multipliée par GEN_SCALE, ce
+ * qui permet d'écrire exactement la même valeur en CSV et en
+ * binaire.
+ *
+ * \param gen paramètres du générateur
+ * \param i indice de la donnée
+ * \param q valeurs de la donnée (entiers)
+ *
+ * \return la classe de la donnée
+ */
+static int gen_row(gen_t * gen, long i, long long * q) {
+  uint64_t s = key_state(gen->seed, i);
+  int c = draw_class(gen, &s), j;
+  const double * center = gen->centers + (size_t)c * gen->dims;
+  double v;
+
+  for(j = 0; j < gen->dims; j++) {
+    if(gen->type == GEN_UNIFORM)
+      v = (2.0 * uniform(&s) - 1.0) * GEN_BOX;
+    else
+      v = center[j] + gen->spread * gaussian(&s);
+    q[j] = llround(v * GEN_SCALE);
+  }
+  return c;
+}
+
+/** \brief Écrit une valeur q / GEN_SCALE avec 4 décimales.
+ *
+ * \param p tampon
+ * \param q valeur multipliée par GEN_SCALE
+ *
+ * \return la position qui suit la valeur écrite
+ */
+static char * format_value(char * p, long long q) {
+  char tmp[24];
+  int n = 0, k;
+  unsigned long long u = q < 0 ? -(unsigned long long)q : (unsigned long long)q;
+
+  if(q < 0) *p++ = '-';
+  for(k = 0; k < 4; k++, u /= 10)
+    tmp[n++] = '0' + u % 10;
+  tmp[n++] = '.';
+  do {
+    tmp[n++] = '0' + u % 10;
+    u /= 10;
+  } while(u);
+  while(n) *p++ = tmp[--n];
+  return p;
+}
+
+/** \brief Ouvre un fichier en écriture avec un grand tampon.
+ *
+ * \param filename nom du fichier
+ */
+static FILE * open_out(char * filename) {
+  FILE * fp = fopen(filename, "wb");
+  if(!fp) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    exit(1);
+  }
+  setvbuf(fp, NULL, _IOFBF, GEN_BUF_SZ);
+  return fp;
+}
+
+/** \brief Ferme un fichier en vérifiant les erreurs d'écriture.
+ *
+ * \param fp fichier
+ * \param filename nom du fichier
+ */
+static void close_out(FILE * fp, char * filename) {
+  if(ferror(fp) | fclose(fp)) {
+    fprintf(stderr, "Error while writing file %s\n", filename);
+    exit(1);
+  }
+}
+
+int main(int argc, char *argv[]) {
+  gen_t gen = { GEN_BLOBS, 1000, 2, 3, 42, 1.0, NULL, NULL };
+  char * csv = NULL, * bin = NULL, name[32], * line, * p;
+  double rows;
+  long i;
+  int opt, c, j, seen = 0;
+
+  while((opt = getopt(argc, argv, "t:n:d:k:s:r:o:b:")) != -1) {
+    switch(opt) {
+      case 't':
+        if(!strcmp(optarg, "blobs")) gen.type = GEN_BLOBS;
+        else if(!strcmp(optarg, "uniform")) gen.type = GEN_UNIFORM;
+        else if(!strcmp(optarg, "imbalanced")) gen.type = GEN_IMBALANCED;
+        else usage(argv[0]);
+        break;
+      case 'n':
+        // accepte la notation scientifique (-n 1e8)
+        rows = strtod(optarg, NULL);
+        if(rows < 1 || rows > INT_MAX) usage(argv[0]);
+        gen.rows = (long)rows;
+        break;
+      case 'd': gen.dims = atoi(optarg); break;
+      case 'k': gen.classes = atoi(optarg); break;
+      case 's': gen.seed = strtoull(optarg, NULL, 10); break;
+      case 'r': gen.spread = strtod(optarg, NULL); break;
+      case 'o': csv = optarg; break;
+      case 'b': bin = optarg; break;
+      default: usage(argv[0]);
+    }
+  }
+  if(optind != argc || (!csv && !bin) || gen.dims < 1 || gen.dims > GEN_MAX_DIMS ||
+      gen.classes < 1 || gen.spread < 0)
+    usage(argv[0]);
+
+  struct timespec t0, t1;
+  clock_gettime(CLOCK_MONOTONIC, &t0);
+
+  init_gen(&gen);
+  long long * q = (long long *)malloc(gen.dims * sizeof(*q));
+  assert(q);
+
+  // dictionnaire des étiquettes dans l'ordre d'apparition, comme
+  // le construit le chargement du fichier CSV
+  labels_t * labels = init_labels();
+  int * ids = (int *)malloc(gen.classes * sizeof(*ids));
+  assert(ids);
+  for(c = 0; c < gen.classes; c++)
+    ids[c] = -1;
+  for(i = 0; i < gen.rows && seen < gen.classes; i++) {
+    uint64_t s = key_state(gen.seed, i);
+    c = draw_class(&gen, &s);
+    if(ids[c] < 0) {
+      snprintf(name, sizeof(name), "c%d", c);
+      ids[c] = add_label(labels, name, strlen(name));
+      seen++;
+    }
+  }
+  for(c = 0; c < gen.classes; c++) {
+    if(ids[c] < 0) {
+      snprintf(name, sizeof(name), "c%d", c);
+      ids[c] = add_label(labels, name, strlen(name));
+    }
+  }
+
+  FILE * fcsv = csv ? open_out(csv) : NULL;
+  FILE * fbin = bin ? open_out(bin) : NULL;
+  int stride = (gen.dims + DATA_SIMD_WIDTH - 1) / DATA_SIMD_WIDTH * DATA_SIMD_WIDTH;
+  ml_real_t * row = (ml_real_t *)calloc(stride, sizeof(*row));
+  assert(row);
+  // une ligne CSV: au plus 24 caractères par valeur et l'étiquette
+  line = (char *)malloc((size_t)gen.dims * 24 + sizeof(name) + 2);
+  assert(line);
+
+  if(fbin)
+    write_bin_header(fbin, gen.rows, gen.dims, stride, labels);
+
+  for(i = 0; i < gen.rows; i++) {
+    c = gen_row(&gen, i, q);
+    if(fcsv) {
+      for(p = line, j = 0; j < gen.dims; j++) {
+        p = format_value(p, q[j]);
+        *p++ = ',';
+      }
+      p += sprintf(p, "c%d\n", c);
+      fwrite(line, 1, p - line, fcsv);
+    }
+    if(fbin) {
+      // division correctement arrondie: même valeur que la lecture
+      // du nombre décimal écrit dans le fichier CSV
+      for(j = 0; j < gen.dims; j++)
+        row[j] = q[j] / GEN_SCALE;
+      fwrite(row, sizeof(*row), stride, fbin);
+    }
+  }
+
+  if(fbin) {
+    // les identifiants d'étiquettes suivent le bloc de données: les
+    // classes sont tirées à nouveau (premier tirage de chaque donnée)
+    for(i = 0; i < gen.rows; i++) {
+      uint64_t s = key_state(gen.seed, i);
+      int32_t id = ids[draw_class(&gen, &s)];
+      fwrite(&id, sizeof(id), 1, fbin);
+    }
+    close_out(fbin, bin);
+  }
+  if(fcsv)
+    close_out(fcsv, csv);
+
+  clock_gettime(CLOCK_MONOTONIC, &t1);
+  printf("%ld x %d, %d classes in %.3f s\n", gen.rows, gen.dims, gen.classes,
+    (t1.tv_sec - t0.tv_sec) + (t1.tv_nsec - t0.tv_nsec) * 1e-9);
+
+  free(line);
+  free(row);
+  free(ids);
+  free(q);
+  free_labels(labels);
+  free(gen.centers);
+  free(gen.cdf);
+  return 0;
+}
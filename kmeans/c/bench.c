@@ -0,0 +1,70 @@
+/*!
+ * \file bench.c
+ * \brief Fichier principale concernant la mesure des
+ * performances de KMeans: chargement, regroupement des données
+ * identiques (DEDUP), apprentissage (toutes les initialisations de
+ * N_INIT, comme kmeans) et prédiction, répétés dans le même processus.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "parser.h"
+#include "config.h"
+#include "kmeans.h"
+
+int main(int argc, char *argv[]) {
+  int reps, r;
+  char * json = NULL;
+  char * filename = bench_args(argc, argv, &reps, &json);
+
+  config_t * cfg = init_config(CONFIG_FILE);
+  bench_t * b = init_bench("kmeans", filename, reps);
+
+  for(r = 0; r < reps; r++) {
+    // mêmes tirages aléatoires à chaque répétition
+    init_rng(cfg->seed);
+
+    bench_start(b);
+    data_t * data = read_file(filename, cfg);
+    bench_stop(b, "load", data->n);
+
+    data_t * uniq = NULL;
+    int * map = NULL;
+    if(cfg->dedup) {
+      bench_start(b);
+      map = (int *)malloc(data->n * sizeof(*map));
+      assert(map);
+      uniq = dedup_data(data, map);
+      cfg->data_sz = uniq->n;
+      bench_stop(b, "dedup", data->n);
+    }
+
+    bench_start(b);
+    kmeans_t * kmeans = fit_kmeans(uniq ? uniq : data, cfg);
+    if(uniq)
+      expand_clusters(kmeans, data, map);
+    bench_stop(b, "train", data->n);
+
+    bench_start(b);
+    int * predicted = predict(kmeans, data, cfg);
+    bench_stop(b, "predict", data->n);
+
+    b->rows = data->n;
+    b->dims = data->d;
+    free(predicted);
+    free_kmeans(kmeans);
+    free_data(data);
+    free_data(uniq);
+    free(map);
+  }
+
+  print_bench(b);
+  if(json)
+    write_bench_json(b, json);
+
+  free_bench(b);
+  free_config(cfg);
+  return 0;
+}
@@ -10,6 +10,27 @@
 #define ASCII_AT 64
 #define ASCII_BRACE 123
 
+/* Moteur d'affectation des données */
+enum {
+  ALGO_LLOYD,  // distances à tous les centroïdes
+  ALGO_ELKAN,  // bornes inférieures par centroïde (n x k) et distances entre centroïdes
+  ALGO_HAMERLY, // une seule borne inférieure par donnée (n)
+  ALGO_GEMM     // produits scalaires par tuiles (||x||² - 2x.c + ||c||²)
+};
+
+/* Initialisation des centroïdes */
+enum {
+  INIT_KMEANSPP,   // k-means++: tirages successifs proportionnels à D²
+  INIT_KMEANS_PAR, // k-means||: tirages parallèles par tours, puis k-means++ pondéré
+  INIT_RANDOM      // données distinctes tirées uniformément
+};
+
+/* Traitement d'un cluster resté vide après l'affectation */
+enum {
+  EMPTY_FARTHEST, // replacé sur la donnée la plus éloignée de son centroïde
+  EMPTY_KEEP      // garde son centroïde précédent
+};
+
 /* Structure représentant la configuration du programme */
 typedef struct config config_t;
 struct config {
@@ -18,6 +39,18 @@ struct config {
   int nb_label;   // nombre de labels
   int n_clusters; // nombre de clusters
   int n_iters;    // nombre d'itérations
+  unsigned long long seed; // graine des tirages aléatoires (0: aléatoire)
+  int empty;      // traitement des clusters vides (EMPTY_*)
+  int init;       // initialisation des centroïdes (INIT_*)
+  int algo;       // moteur d'affectation (ALGO_*)
+  int batch_sz;   // taille des mini-batchs (0: toutes les données à chaque itération)
+  double batch_tol; // seuil de déplacement des centroïdes en mini-batch (relatif à la variance)
+  int n_threads;  // nombre de threads (0: nombre de processeurs)
+  int n_init;     // nombre d'initialisations exécutées en parallèle (0 ou 1: une seule)
+  double tol;     // seuil de déplacement des centroïdes (relatif à la variance, 0: aucun)
+  int verbose;    // affichage de chaque itération
+  int warm_iters; // passes de Lloyd après l'ajout de nouvelles données à un modèle
+  int dedup;      // regroupement des données identiques en données pondérées
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,70 @@
+/*!
+ * \file gemm_impl.h
+ * \brief Modèle du noyau de produits scalaires par tuiles de
+ * l'affectation GEMM, inclus par kmeans.c une fois par jeu
+ * d'instructions après avoir défini ISA (suffixe des fonctions),
+ * ATTR (attribut target) et W (nombre de doubles par registre, qui
+ * divise GEMM_NR). Chaque ligne d'une micro-tuile occupe GEMM_NR / W
+ * registres.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#define GEMM__(name, isa) name##_##isa
+#define GEMM_(name, isa) GEMM__(name, isa)
+#define GEMM(name) GEMM_(name, ISA)
+
+/** \brief Registre de W doubles (extension vectorielle de gcc), lu
+ * et écrit en mémoire sans contrainte d'alignement */
+typedef double GEMM(vec_t) __attribute__((vector_size(W * sizeof(double)), aligned(sizeof(double))));
+
+/** \brief Produits scalaires d'une tuile de données avec tous les
+ * centroïdes: g[p][c] = x_p.c_c, par micro-tuiles GEMM_MR x GEMM_NR
+ * gardées en registres et par blocs de KMEANS_KC dimensions. Les
+ * centroïdes d'une micro-tuile forment un panneau contigu (lu
+ * séquentiellement, il reste dans le cache L1). Les blocs de
+ * profondeur suivants s'ajoutent au premier.
+ *
+ * \param x première donnée de la tuile
+ * \param stride pas entre deux données
+ * \param rows nombre de données de la tuile
+ * \param ct centroïdes transposés par panneaux (k_pad / GEMM_NR x d x GEMM_NR)
+ * \param k_pad nombre de colonnes de ct (multiple de GEMM_NR)
+ * \param d nombre de valeurs par donnée
+ * \param g produits scalaires (rows x k_pad)
+ */
+static ATTR void GEMM(gemm_tile)(const ml_real_t * x, int stride, int rows,
+    const double * ct, int k_pad, int d, double * g) {
+  GEMM(vec_t) acc[GEMM_MR][GEMM_NR / W], w[GEMM_NR / W];
+  const ml_real_t * xp[GEMM_MR];
+  const double * panel;
+  double * gp;
+  int j0, j1, j, c0, p0, p, v;
+
+  for(j0 = 0; j0 < d; j0 = j1) {
+    j1 = d - j0 < KMEANS_KC ? d : j0 + KMEANS_KC;
+    for(c0 = 0; c0 < k_pad; c0 += GEMM_NR)
+      for(panel = ct + (size_t)c0 * d, p0 = 0; p0 < rows; p0 += GEMM_MR) {
+        // dernière micro-tuile incomplète: la dernière donnée est répétée
+        for(p = 0; p < GEMM_MR; p++) {
+          xp[p] = x + (size_t)(p0 + p < rows ? p0 + p : rows - 1) * stride;
+          for(v = 0; v < GEMM_NR / W; v++)
+            acc[p][v] = (GEMM(vec_t)){ 0 };
+        }
+
+        for(j = j0; j < j1; j++) {
+          for(v = 0; v < GEMM_NR / W; v++)
+            w[v] = *(const GEMM(vec_t) *)(panel + (size_t)j * GEMM_NR + v * W);
+          for(p = 0; p < GEMM_MR; p++)
+            for(v = 0; v < GEMM_NR / W; v++)
+              acc[p][v] += (double)xp[p][j] * w[v];
+        }
+
+        for(p = 0; p < GEMM_MR && p0 + p < rows; p++)
+          for(gp = g + (size_t)(p0 + p) * k_pad + c0, v = 0; v < GEMM_NR / W; v++)
+            *(GEMM(vec_t) *)(gp + v * W) = j0 ? *(GEMM(vec_t) *)(gp + v * W) + acc[p][v] : acc[p][v];
+      }
+  }
+}
+
+#undef GEMM__
+#undef GEMM_
+#undef GEMM
@@ -11,8 +11,86 @@
 #include <string.h>
 #include <time.h>
 #include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "kmeans.h"
 
+#define KMEANS_BLOCK_MIN 4096 // nombre minimal de données par bloc
+#define KMEANS_MAX_BLOCKS 256 // nombre maximal de blocs
+#define KMEANS_OVERSAMPLING 2 // candidats tirés par tour de k-means||, en multiple de k
+#define KMEANS_PAR_ROUNDS 5   // nombre de tours de k-means||
+#define KMEANS_MB_PATIENCE 10 // mini-batchs consécutifs sous le seuil avant l'arrêt
+#define KMEANS_TILE 64        // données par tuile (GEMM)
+#define KMEANS_KC 256         // dimensions par bloc de profondeur (GEMM)
+#define GEMM_MR 4             // données par micro-tuile (GEMM)
+#define GEMM_NR 8             // centroïdes par micro-tuile (GEMM)
+#define KMEANS_SHRINK (1.0f - 0x1p-22f) // absorbe l'arrondi de la mise à jour des bornes d'Elkan
+
+/** \brief Accède à la valeur j du centroïde c dans les centroïdes
+ * transposés: panneaux de GEMM_NR centroïdes, d x GEMM_NR contigus */
+#define CT(kmeans, d, j, c) ((kmeans)->ct[((size_t)(c) / GEMM_NR * (d) + (j)) * GEMM_NR + (c) % GEMM_NR])
+
+/** \brief Accède à la somme des données du cluster c */
+#define SUM(kmeans, c) ((kmeans)->sums + (size_t)(c) * (kmeans)->stride)
+
+/** \brief Poids de la donnée i (nombre de copies, voir dedup_data) */
+#define WEIGHT(kmeans, i) ((kmeans)->data->weight ? (kmeans)->data->weight[i] : 1)
+
+/** \brief Structure représentant un thread du clustering */
+typedef struct worker worker_t;
+struct worker {
+  kmeans_t * kmeans;           // modèle KMeans
+  config_t * cfg;              // données de configuration
+  int id;                      // numéro du thread
+  int * done;                  // clustering terminé (partagé)
+  pthread_barrier_t * barrier; // barrière de fin de chaque étape
+};
+
+/** \brief Structure représentant un thread exécutant une
+ * fonction sur une partie des blocs */
+typedef struct task task_t;
+struct task {
+  kmeans_t * kmeans; // modèle KMeans
+  config_t * cfg;    // données de configuration
+  int id;            // numéro du thread
+  void (*fn)(kmeans_t *, int, config_t *, void *); // fonction appliquée à chaque bloc
+  void * arg;        // argument de la fonction
+};
+
+/** \brief Structure représentant un thread exécutant une partie
+ * des initialisations (les initialisations r telles que r modulo
+ * n_runners vaut son numéro) */
+typedef struct restart restart_t;
+struct restart {
+  data_t * data;    // données (partagées, en lecture seule)
+  config_t cfg;     // configuration de ses clusterings (threads répartis)
+  int id;           // numéro du thread
+  int n_runners;    // nombre de threads d'initialisations
+  kmeans_t * best;  // meilleur modèle obtenu par le thread
+  int best_r;       // initialisation qui l'a produit
+};
+
+/** \brief Structure représentant l'état de l'initialisation
+ * k-means++ ou k-means||: candidats choisis et distance de
+ * chaque donnée au plus proche d'entre eux */
+typedef struct seeding seeding_t;
+struct seeding {
+  double * dist;       // distance au carré de chaque donnée au candidat le plus proche
+  int * near;          // candidat le plus proche de chaque donnée (k-means||, NULL sinon)
+  double * psi;        // somme des distances de chaque bloc
+  double psi_sum;      // somme des distances de toutes les données
+  int * cand;          // indices des données candidates
+  int n_cand;          // nombre de candidats
+  int cap;             // capacité de cand
+  int first;           // premier candidat absent de dist
+  int ** picked;       // candidats tirés par chaque bloc pendant un tour (k-means||)
+  int * n_picked;      // nombre de candidats tirés par chaque bloc
+  int * picked_cap;    // capacité de picked
+  uint64_t round_seed; // graine du tour (k-means||)
+};
+
 /** \brief Récupère l'indice du tableau, selon la valeur donnée.
  *
  * \param arr tableau
@@ -31,184 +109,1957 @@ static int get_index(int * arr, int idx, int val, int size) {
   return -1;
 }
 
-/** \brief Initialise les centroïdes pour le KMeans.
+/** \brief Initialise les identifiants de cluster des données.
  *
  * \param kmeans modèle KMeans
  * \param data données
+ * \param data_sz nombre de données
+ */
+static void init_points(kmeans_t * kmeans, data_t * data, int data_sz) {
+  kmeans->data = data;
+  kmeans->cluster_id = (int *)malloc(data_sz * sizeof(*kmeans->cluster_id));
+  assert(kmeans->cluster_id);
+
+  int i;
+  for(i = 0; i < data_sz; i++)
+    kmeans->cluster_id[i] = -1;
+}
+
+/** \brief Trouvant le centroïde le plus
+ * proche de la donnée (comparaison des distances
+ * euclidiennes au carré).
+ *
+ * \param kmeans modèle KMeans
+ * \param v vecteur de la donnée
  * \param cfg données de configuration
+ *
+ * \return le centroïde le plus proche de la donnée.
  */
-static void init_centroids(kmeans_t * kmeans, data_t * data, config_t * cfg) {
-  srand(time(NULL));
+static int find_cluster(kmeans_t * kmeans, const ml_real_t * v, config_t * cfg) {
+  int cl, min_cl = 0;
+  double dist, min_dist = sq_l2_dist(
+    CENTROID(kmeans, 0), v, cfg->nb_val);
 
-  int r, i, c = 0;
-  int * centroids = (int *)calloc(0, kmeans->n_clusters * sizeof(*kmeans->centroids));
-  assert(centroids);
+  for(cl = 1; cl < kmeans->n_clusters; cl++) {
+    dist = sq_l2_dist(CENTROID(kmeans, cl), v, cfg->nb_val);
+    if(sq_dist_cmp(dist, min_dist) < 0) {
+      min_dist = dist;
+      min_cl = cl;
+    }
+  }
+
+  return min_cl;
+}
+
+/** \brief Arrondit une distance vers le haut de la marge des bornes:
+ * le résultat majore la distance exacte comme la distance calculée.
+ *
+ * \param kmeans modèle KMeans
+ * \param d distance
+ *
+ * \return la borne supérieure
+ */
+static inline double bound_up(kmeans_t * kmeans, double d) {
+  return d * (1.0 + kmeans->eps);
+}
+
+/** \brief Arrondit une distance vers le bas de la marge des bornes,
+ * en simple précision (bornes inférieures), sans devenir négative.
+ *
+ * \param kmeans modèle KMeans
+ * \param d distance
+ *
+ * \return la borne inférieure
+ */
+static inline float bound_down(kmeans_t * kmeans, double d) {
+  float f;
+  if(!(d > 0.0))
+    return 0.0f;
+  d *= 1.0 - kmeans->eps;
+  f = (float)d;
+  return (double)f > d ? nextafterf(f, 0.0f) : f;
+}
 
-  kmeans->centroids = (double **)malloc(kmeans->n_clusters * sizeof(*kmeans->centroids));
-  assert(kmeans->centroids);
+/** \brief Calcule les distances d'une donnée à tous les centroïdes et
+ * choisit le plus proche comme find_cluster. Les bornes de la donnée
+ * sont réinitialisées: distance exacte à chaque centroïde (Elkan) ou
+ * distance au deuxième plus proche (Hamerly).
+ *
+ * \param kmeans modèle KMeans
+ * \param i indice de la donnée
+ * \param v vecteur de la donnée
+ * \param cfg données de configuration
+ *
+ * \return le centroïde le plus proche de la donnée.
+ */
+static int scan_bounds(kmeans_t * kmeans, int i, const ml_real_t * v, config_t * cfg) {
+  float * lower = cfg->algo == ALGO_ELKAN ? kmeans->lower + (size_t)i * kmeans->n_clusters : NULL;
+  double dist, min_dist = HUGE_VAL, second = HUGE_VAL;
+  int cl, min_cl = 0;
 
-  for(i = 0; i < kmeans->n_clusters; i++) {
-    kmeans->centroids[i] = (double *)malloc(cfg->nb_val * sizeof(*kmeans->centroids[i]));
-    assert(kmeans->centroids[i]);
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    dist = sq_l2_dist(CENTROID(kmeans, cl), v, cfg->nb_val);
+    if(lower)
+      lower[cl] = bound_down(kmeans, sqrt(dist));
+    if(!cl || sq_dist_cmp(dist, min_dist) < 0) {
+      if(cl)
+        second = min_dist;
+      min_dist = dist;
+      min_cl = cl;
+    } else if(dist < second)
+      second = dist;
   }
 
-  do {
-    r = rand() % cfg->data_sz;
+  kmeans->upper[i] = bound_up(kmeans, sqrt(min_dist));
+  if(!lower)
+    kmeans->lower[i] = bound_down(kmeans, sqrt(second));
+  return min_cl;
+}
 
-    while(1) {
-      if(~get_index(centroids, c, r, kmeans->n_clusters)) r = rand() % cfg->data_sz;
-      else break;
+/** \brief Affectation d'Elkan: les bornes inférieures de la donnée
+ * (une par centroïde) et la moitié des distances entre centroïdes
+ * évitent les distances qui ne peuvent pas changer l'affectation.
+ * Les tests sont stricts et les bornes élargies des erreurs
+ * d'arrondi: le résultat est celui de find_cluster.
+ *
+ * \param kmeans modèle KMeans
+ * \param i indice de la donnée
+ * \param v vecteur de la donnée
+ * \param cfg données de configuration
+ *
+ * \return le centroïde le plus proche de la donnée.
+ */
+static int elkan_cluster(kmeans_t * kmeans, int i, const ml_real_t * v, config_t * cfg) {
+  float * lower = kmeans->lower + (size_t)i * kmeans->n_clusters;
+  int cl, a = kmeans->cluster_id[i], tight = 0;
+  double u, dist, min_dist = 0.0;
+
+  if(!kmeans->bounded || a < 0)
+    return scan_bounds(kmeans, i, v, cfg);
+
+  // (l - delta) arrondi au plus près puis réduit de 2^-22: reste sous l - delta
+  u = bound_up(kmeans, kmeans->upper[i] + kmeans->delta[a]);
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    float l = (lower[cl] - kmeans->delta_f[cl]) * KMEANS_SHRINK;
+    lower[cl] = l > 0.0f ? l : 0.0f;
+  }
+
+  if(u < kmeans->half_min[a]) {
+    kmeans->upper[i] = u;
+    return a;
+  }
+
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    if(cl == a || u < lower[cl] || u < kmeans->half_cc[(size_t)a * kmeans->n_clusters + cl])
+      continue;
+
+    if(!tight) {
+      min_dist = sq_l2_dist(CENTROID(kmeans, a), v, cfg->nb_val);
+      u = bound_up(kmeans, sqrt(min_dist));
+      lower[a] = bound_down(kmeans, sqrt(min_dist));
+      tight = 1;
+      if(u < lower[cl] || u < kmeans->half_cc[(size_t)a * kmeans->n_clusters + cl])
+        continue;
     }
 
-    centroids[c] = r;
-    kmeans->centroids[c] = data[r].v;
-    c++;
-  } while(c < kmeans->n_clusters);
+    dist = sq_l2_dist(CENTROID(kmeans, cl), v, cfg->nb_val);
+    lower[cl] = bound_down(kmeans, sqrt(dist));
+    if(sq_dist_cmp(dist, min_dist) < 0 || (!sq_dist_cmp(dist, min_dist) && cl < a)) {
+      min_dist = dist;
+      a = cl;
+      u = bound_up(kmeans, sqrt(dist));
+    }
+  }
+
+  kmeans->upper[i] = u;
+  return a;
 }
 
-/** \brief Initialise les points représentant les données.
+/** \brief Affectation de Hamerly: une borne inférieure de la distance
+ * au deuxième centroïde le plus proche évite, si elle dépasse la
+ * borne supérieure, de calculer les distances de la donnée. Sinon,
+ * toutes les distances sont calculées.
  *
  * \param kmeans modèle KMeans
- * \param data données
- * \param data_sz nombre de données
+ * \param i indice de la donnée
+ * \param v vecteur de la donnée
+ * \param cfg données de configuration
+ *
+ * \return le centroïde le plus proche de la donnée.
  */
-static void init_points(kmeans_t * kmeans, data_t * data, int data_sz) {
-  kmeans->points = (point_t *)malloc(data_sz * sizeof(*kmeans->points));
-  assert(kmeans->points);
+static int hamerly_cluster(kmeans_t * kmeans, int i, const ml_real_t * v, config_t * cfg) {
+  int a = kmeans->cluster_id[i];
+  double u, l, m;
 
-  int i;
-  for(i = 0; i < data_sz; i++) {
-    kmeans->points[i].data = data[i];
-    kmeans->points[i].cluster_id = -1;
+  if(!kmeans->bounded || a < 0)
+    return scan_bounds(kmeans, i, v, cfg);
+
+  u = bound_up(kmeans, kmeans->upper[i] + kmeans->delta[a]);
+  l = bound_down(kmeans, kmeans->lower[i] - kmeans->delta_max[a == kmeans->delta_arg]);
+  kmeans->lower[i] = l;
+  m = l > kmeans->half_min[a] ? l : kmeans->half_min[a];
+
+  if(u >= m) {
+    u = bound_up(kmeans, sqrt(sq_l2_dist(CENTROID(kmeans, a), v, cfg->nb_val)));
+    if(u >= m)
+      return scan_bounds(kmeans, i, v, cfg);
+  }
+
+  kmeans->upper[i] = u;
+  return a;
+}
+
+/** \brief Affecte une donnée avec le moteur choisi (cfg->algo).
+ *
+ * \param kmeans modèle KMeans
+ * \param i indice de la donnée
+ * \param v vecteur de la donnée
+ * \param cfg données de configuration
+ *
+ * \return le centroïde le plus proche de la donnée.
+ */
+static inline int assign_point(kmeans_t * kmeans, int i, const ml_real_t * v, config_t * cfg) {
+  switch(kmeans->upper ? cfg->algo : ALGO_LLOYD) {
+    case ALGO_ELKAN:   return elkan_cluster(kmeans, i, v, cfg);
+    case ALGO_HAMERLY: return hamerly_cluster(kmeans, i, v, cfg);
+    default:           return find_cluster(kmeans, v, cfg);
   }
 }
 
-/** \brief Calcule la distance euclidienne de deux vecteurs.
+/** \brief Ajoute une donnée à la somme de son cluster.
  *
- * \param v vecteur v
- * \param w vecteur w
- * \param size taille des vecteurs v et w (partageant la même taille)
+ * \param sum somme des données du cluster
+ * \param v vecteur de la donnée
+ * \param n nombre de valeurs
+ */
+static inline void add_point(double * sum, const ml_real_t * v, int n) {
+  int i;
+  for(i = 0; i < n; i++)
+    sum[i] += v[i];
+}
+
+/** \brief Ajoute une donnée pondérée à la somme de son cluster.
  *
- * \return la distance de l'ensemble des deux vecteurs.
+ * \param sum somme des données du cluster
+ * \param v vecteur de la donnée
+ * \param w poids de la donnée
+ * \param n nombre de valeurs
  */
-static double euclidean_dist(double * v, double * w, int size) {
-  double sum = 0;
+static inline void add_weighted(double * sum, const ml_real_t * v, int w, int n) {
   int i;
-  for(i = 0; i < size; i++)
-    sum += pow(v[i] - w[i], 2.0);
-  return sqrt(sum);
+  if(w == 1) {
+    add_point(sum, v, n);
+    return;
+  }
+  for(i = 0; i < n; i++)
+    sum[i] += (double)w * v[i];
 }
 
-/** \brief Trouvant le centroïde le plus
- * proche de la donnée.
+/** \brief Tire une donnée avec une probabilité proportionnelle à son
+ * poids (uniformément si les données ne sont pas pondérées).
  *
  * \param kmeans modèle KMeans
- * \param pt point représentant la donnée
- * \param data données
- * \param cfg données de configuration
  *
- * \return le centroïde le plus proche de la donnée.
+ * \return l'indice de la donnée tirée
  */
-static int find_cluster(kmeans_t * kmeans, point_t pt, data_t * data, config_t * cfg) {
-  int cl, min_cl = 0;
-  double dist, min_dist = euclidean_dist(
-    kmeans->centroids[0], pt.data.v, cfg->nb_val);
+static int rand_point(kmeans_t * kmeans) {
+  int lo = 0, hi = kmeans->data_sz - 1, mid;
+  double u;
 
-  for(cl = 1; cl < kmeans->n_clusters; cl++) {
-    dist = euclidean_dist(kmeans->centroids[cl], pt.data.v, cfg->nb_val);
-    if(dist < min_dist) {
-      min_dist = dist;
-      min_cl = cl;
+  if(!kmeans->cum_weight)
+    return rand_int(kmeans->data_sz);
+
+  u = rng_uniform(rng_local()) * kmeans->cum_weight[hi];
+  while(lo < hi) {
+    mid = (lo + hi) / 2;
+    if(kmeans->cum_weight[mid] > u)
+      hi = mid;
+    else
+      lo = mid + 1;
+  }
+  return lo;
+}
+
+/** \brief Replace le centroïde d'un cluster vide sur la donnée
+ * la plus éloignée du centroïde de son cluster, en la retirant
+ * (avec toutes ses copies si elle est pondérée) de ce dernier, qui
+ * doit garder au moins une donnée.
+ *
+ * \param kmeans modèle KMeans
+ * \param cl cluster vide
+ * \param cfg données de configuration
+ */
+static void relocate_centroid(kmeans_t * kmeans, int cl, config_t * cfg) {
+  int i, old, w, far = -1;
+  double dist, max_dist = -1.0;
+
+  for(i = 0; i < kmeans->data_sz; i++) {
+    old = kmeans->cluster_id[i];
+    if(kmeans->counts[old] <= WEIGHT(kmeans, i))
+      continue;
+    dist = sq_l2_dist(CENTROID(kmeans, old), DATA_ROW(kmeans->data, i), cfg->nb_val);
+    if(dist > max_dist) {
+      max_dist = dist;
+      far = i;
     }
   }
 
-  return min_cl;
+  // moins de données distinctes que de clusters: le cluster reste vide
+  if(far < 0)
+    return;
+
+  const ml_real_t * v = DATA_ROW(kmeans->data, far);
+  old = kmeans->cluster_id[far];
+  w = WEIGHT(kmeans, far);
+  kmeans->counts[old] -= w;
+  for(i = 0; i < cfg->nb_val; i++) {
+    SUM(kmeans, old)[i] -= (double)w * v[i];
+    CENTROID(kmeans, old)[i] = SUM(kmeans, old)[i] / kmeans->counts[old];
+    SUM(kmeans, cl)[i] = (double)w * v[i];
+  }
+  memcpy(CENTROID(kmeans, cl), v, kmeans->stride * sizeof(*kmeans->centroids));
+  kmeans->counts[cl] = w;
+  kmeans->cluster_id[far] = cl;
+
+  // bornes de la donnée déplacée: distance au nouveau centroïde à recalculer
+  if(kmeans->upper)
+    kmeans->upper[far] = HUGE_VAL;
+  if(cfg->algo == ALGO_HAMERLY)
+    kmeans->lower[far] = 0.0f;
 }
 
-/** \brief Met à jour les centroïdes.
+/** \brief Met à jour les centroïdes à partir des sommes et des
+ * effectifs accumulés pendant l'affectation. Un cluster vide est
+ * traité selon cfg->empty (EMPTY_FARTHEST ou EMPTY_KEEP).
  *
  * \param kmeans modèle KMeans
  * \param cfg données de configuration
  */
 static void update_centroids(kmeans_t * kmeans, config_t * cfg) {
-  int cl, i, d, cluster_sz = 0;
-  double sum = 0.0;
+  PROF_BEGIN(update, "update_centroids");
+  int cl, i;
   for(cl = 0; cl < kmeans->n_clusters; cl++) {
-    for(i = 0; i < cfg->nb_val; i++) {
-      sum = 0.0;
-      cluster_sz = 0;
-      for(d = 0; d < kmeans->data_sz; d++) {
-        if(kmeans->points[d].cluster_id == cl) {
-          sum += kmeans->points[d].data.v[i];
-          cluster_sz++;
-        }
+    if(!kmeans->counts[cl])
+      continue;
+    for(i = 0; i < cfg->nb_val; i++)
+      CENTROID(kmeans, cl)[i] = SUM(kmeans, cl)[i] / kmeans->counts[cl];
+  }
+
+  if(cfg->empty == EMPTY_FARTHEST)
+    for(cl = 0; cl < kmeans->n_clusters; cl++)
+      if(!kmeans->counts[cl])
+        relocate_centroid(kmeans, cl, cfg);
+  PROF_END(update);
+}
+
+/** \brief Calcule le déplacement des centroïdes depuis
+ * kmeans->prev.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ *
+ * \return la somme des carrés des déplacements
+ */
+static double centroid_shift(kmeans_t * kmeans, config_t * cfg) {
+  double shift = 0.0;
+  int cl;
+  for(cl = 0; cl < kmeans->n_clusters; cl++)
+    shift += sq_l2_dist(kmeans->prev + (size_t)cl * kmeans->stride, CENTROID(kmeans, cl), cfg->nb_val);
+  return shift;
+}
+
+/** \brief Calcule la moitié des distances entre centroïdes
+ * (Elkan) et, pour chaque centroïde, la moitié de la distance au
+ * plus proche autre centroïde, arrondies vers le bas.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void center_bounds(kmeans_t * kmeans, config_t * cfg) {
+  int k = kmeans->n_clusters, a, b;
+  double d;
+
+  for(a = 0; a < k; a++)
+    kmeans->half_min[a] = HUGE_VAL;
+  for(a = 0; a < k; a++)
+    for(b = a + 1; b < k; b++) {
+      d = 0.5 * bound_down(kmeans, sqrt(sq_l2_dist(CENTROID(kmeans, a), CENTROID(kmeans, b), cfg->nb_val)));
+      if(kmeans->half_cc) {
+        kmeans->half_cc[(size_t)a * k + b] = d;
+        kmeans->half_cc[(size_t)b * k + a] = d;
       }
-      kmeans->centroids[cl][i] = sum / cluster_sz;
+      if(d < kmeans->half_min[a]) kmeans->half_min[a] = d;
+      if(d < kmeans->half_min[b]) kmeans->half_min[b] = d;
+    }
+}
+
+/** \brief Calcule le déplacement de chaque centroïde depuis
+ * kmeans->prev, arrondi vers le haut, puis les distances entre
+ * les nouveaux centroïdes.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void move_bounds(kmeans_t * kmeans, config_t * cfg) {
+  int cl;
+  double d;
+
+  kmeans->delta_max[0] = kmeans->delta_max[1] = 0.0;
+  kmeans->delta_arg = -1;
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    d = sq_l2_dist(kmeans->prev + (size_t)cl * kmeans->stride, CENTROID(kmeans, cl), cfg->nb_val);
+    d = kmeans->delta[cl] = d > 0.0 ? bound_up(kmeans, sqrt(d)) : 0.0;
+    if(kmeans->delta_f) {
+      kmeans->delta_f[cl] = (float)d;
+      if((double)kmeans->delta_f[cl] < d)
+        kmeans->delta_f[cl] = nextafterf(kmeans->delta_f[cl], HUGE_VALF);
     }
+    if(d > kmeans->delta_max[0]) {
+      kmeans->delta_max[1] = kmeans->delta_max[0];
+      kmeans->delta_max[0] = d;
+      kmeans->delta_arg = cl;
+    } else if(d > kmeans->delta_max[1])
+      kmeans->delta_max[1] = d;
   }
+  center_bounds(kmeans, cfg);
 }
 
-/** \brief Initialise le modèle KMeans: cluster,
- * centroïdes et points.
+/** \brief Alloue les bornes d'Elkan ou de Hamerly. Elles sont
+ * initialisées par la première affectation de cluster().
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void init_bounds(kmeans_t * kmeans, config_t * cfg) {
+  size_t n = kmeans->data_sz, k = kmeans->n_clusters;
+
+  kmeans->bounded = 0;
+  if(kmeans->upper || (cfg->algo != ALGO_ELKAN && cfg->algo != ALGO_HAMERLY))
+    return;
+
+  kmeans->upper = (double *)malloc(n * sizeof(*kmeans->upper));
+  kmeans->lower = (float *)malloc((cfg->algo == ALGO_ELKAN ? n * k : n) * sizeof(*kmeans->lower));
+  kmeans->half_min = (double *)malloc(k * sizeof(*kmeans->half_min));
+  kmeans->delta = (double *)calloc(k, sizeof(*kmeans->delta));
+  if(!kmeans->upper || !kmeans->lower || !kmeans->half_min || !kmeans->delta) {
+    fprintf(stderr, "Can't allocate the bounds of %d data\n", kmeans->data_sz);
+    exit(1);
+  }
+  if(cfg->algo == ALGO_ELKAN) {
+    kmeans->half_cc = (double *)malloc(k * k * sizeof(*kmeans->half_cc));
+    kmeans->delta_f = (float *)malloc(k * sizeof(*kmeans->delta_f));
+    assert(kmeans->half_cc && kmeans->delta_f);
+  }
+}
+
+/** \brief Renvoie le nombre de threads demandé.
  *
- * \param data données
  * \param cfg données de configuration
  *
- * \return le modèle KMeans.
+ * \return cfg->n_threads, ou le nombre de processeurs s'il est nul
  */
-kmeans_t * init_kmeans(data_t * data, config_t * cfg) {
-  kmeans_t * kmeans = (kmeans_t *)malloc(sizeof(*kmeans));
-  assert(kmeans);
+static int nb_threads(config_t * cfg) {
+  long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  return cfg->n_threads > 0 ? cfg->n_threads : (nb_cpus > 0 ? nb_cpus : 1);
+}
 
-  kmeans->n_clusters = cfg->n_clusters;
-  kmeans->data_sz = cfg->data_sz;
+/** \brief Découpe les données en blocs dont chacun est affecté par
+ * un seul thread. Le découpage ne dépend que du nombre de données:
+ * les sommes partielles, réduites dans l'ordre des blocs, donnent
+ * les mêmes centroïdes quel que soit le nombre de threads.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void split_blocks(kmeans_t * kmeans, config_t * cfg) {
+  int b;
 
-  init_centroids(kmeans, data, cfg);
-  init_points(kmeans, data, cfg->data_sz);
+  kmeans->n_blocks = (kmeans->data_sz + KMEANS_BLOCK_MIN - 1) / KMEANS_BLOCK_MIN;
+  if(kmeans->n_blocks > KMEANS_MAX_BLOCKS) kmeans->n_blocks = KMEANS_MAX_BLOCKS;
+  if(kmeans->n_blocks < 1) kmeans->n_blocks = 1;
 
-  return kmeans;
+  kmeans->n_threads = nb_threads(cfg);
+  if(kmeans->n_threads > kmeans->n_blocks) kmeans->n_threads = kmeans->n_blocks;
+
+  kmeans->blocks = (kblock_t *)calloc(kmeans->n_blocks, sizeof(*kmeans->blocks));
+  assert(kmeans->blocks);
+  for(b = 0; b < kmeans->n_blocks; b++) {
+    kmeans->blocks[b].from = (size_t)kmeans->data_sz * b / kmeans->n_blocks;
+    kmeans->blocks[b].to = (size_t)kmeans->data_sz * (b + 1) / kmeans->n_blocks;
+  }
 }
 
-void cluster(kmeans_t * kmeans, data_t * data, config_t * cfg) {
-  int i, it, cluster_id, clusterized;
+/** \brief Découpe les données en blocs (split_blocks) et alloue les
+ * sommes et effectifs partiels de chaque bloc.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void init_blocks(kmeans_t * kmeans, config_t * cfg) {
+  size_t sz = (size_t)kmeans->n_clusters * kmeans->stride * sizeof(double)
+    + kmeans->n_clusters * sizeof(int);
+  int b;
 
-  for(it = 0; it < cfg->n_iters; it++) {
-    clusterized = 1;
-    for(i = 0; i < kmeans->data_sz; i++) {
-      cluster_id = find_cluster(kmeans, kmeans->points[i], data, cfg);
-      if(kmeans->points[i].cluster_id != cluster_id) {
-        kmeans->points[i].cluster_id = cluster_id;
-        clusterized = 0;
-      }
+  split_blocks(kmeans, cfg);
+
+  // un bloc mémoire aligné par bloc: pas de ligne de cache partagée entre threads
+  sz = (sz + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+  for(b = 0; b < kmeans->n_blocks; b++) {
+    kblock_t * bl = &kmeans->blocks[b];
+    if(posix_memalign((void **)&bl->sums, DATA_ALIGN, sz)) {
+      fprintf(stderr, "Can't allocate %d blocks\n", kmeans->n_blocks);
+      exit(1);
+    }
+    bl->counts = (int *)(bl->sums + (size_t)kmeans->n_clusters * kmeans->stride);
+  }
+}
+
+/** \brief Exécute les blocs d'un thread (les blocs b tels que
+ * b modulo n_threads vaut son numéro).
+ *
+ * \param arg thread (task_t)
+ *
+ * \return NULL
+ */
+static void * run_task(void * arg) {
+  task_t * t = (task_t *)arg;
+  int b;
+
+  for(b = t->id; b < t->kmeans->n_blocks; b += t->kmeans->n_threads)
+    t->fn(t->kmeans, b, t->cfg, t->arg);
+  return NULL;
+}
+
+/** \brief Applique une fonction à chaque bloc de données, les blocs
+ * étant répartis sur kmeans->n_threads threads.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ * \param fn fonction appliquée à chaque bloc
+ * \param arg argument de la fonction
+ */
+static void run_blocks(kmeans_t * kmeans, config_t * cfg,
+    void (*fn)(kmeans_t *, int, config_t *, void *), void * arg) {
+  pthread_t * threads = (pthread_t *)malloc(kmeans->n_threads * sizeof(*threads));
+  task_t * tasks = (task_t *)calloc(kmeans->n_threads, sizeof(*tasks));
+  assert(threads && tasks);
+  int i;
+
+  for(i = 0; i < kmeans->n_threads; i++) {
+    tasks[i].kmeans = kmeans;
+    tasks[i].cfg = cfg;
+    tasks[i].id = i;
+    tasks[i].fn = fn;
+    tasks[i].arg = arg;
+  }
+
+  for(i = 1; i < kmeans->n_threads; i++)
+    if(pthread_create(&threads[i], NULL, run_task, &tasks[i])) {
+      fprintf(stderr, "Can't create thread\n");
+      exit(1);
     }
+  run_task(&tasks[0]);
+  for(i = 1; i < kmeans->n_threads; i++)
+    pthread_join(threads[i], NULL);
+
+  free(tasks);
+  free(threads);
+}
+
+/* Version de base: registres de 128 bits (SSE2, NEON) */
+#define ISA base
+#define ATTR
+#define W 2
+#include "gemm_impl.h"
+#undef ISA
+#undef ATTR
+#undef W
 
-    if(clusterized)
+#if defined(__x86_64__) || defined(__i386__)
+/* AVX2 + FMA: deux registres par ligne de micro-tuile */
+#define ISA avx2
+#define ATTR __attribute__((target("avx2,fma")))
+#define W 4
+#include "gemm_impl.h"
+#undef ISA
+#undef ATTR
+#undef W
+
+/* AVX-512F: un registre par ligne de micro-tuile */
+#define ISA avx512
+#define ATTR __attribute__((target("avx512f")))
+#define W 8
+#include "gemm_impl.h"
+#undef ISA
+#undef ATTR
+#undef W
+#endif
+
+/** \brief Versions de gemm_tile, associées aux noyaux de distance de
+ * libml: la version utilisée suit le jeu choisi par ml_dist (et ML_ISA) */
+static const struct {
+  const char * name;
+  void (* tile)(const ml_real_t *, int, int, const double *, int, int, double *);
+} gemm_kernels[] = {
+#if defined(__x86_64__) || defined(__i386__)
+  { "avx2",   gemm_tile_avx2 },
+  { "avx512", gemm_tile_avx512 },
+#endif
+  { NULL,     gemm_tile_base }
+};
+
+/** \brief Choisit la version de gemm_tile correspondant aux noyaux
+ * de distance choisis par libml.
+ *
+ * \param kmeans modèle KMeans
+ */
+static void gemm_kernel(kmeans_t * kmeans) {
+  int i;
+  for(i = 0; gemm_kernels[i].name; i++)
+    if(!strcmp(gemm_kernels[i].name, ml_dist.name))
       break;
+  kmeans->gemm = gemm_kernels[i].tile;
+}
+
+/** \brief Affecte une tuile de données par produits scalaires:
+ * ||x - c||² = ||x||² - 2x.c + ||c||², minimum cherché dans la même
+ * passe que le calcul des distances (épilogue de la tuile). Les
+ * distances négatives dues aux arrondis sont ramenées à 0. Si l'écart
+ * entre les deux plus proches centroïdes ne dépasse pas l'erreur
+ * d'arrondi possible de cette formule, la donnée est affectée par
+ * find_cluster: le résultat est toujours celui de l'algorithme de Lloyd.
+ *
+ * \param kmeans modèle KMeans
+ * \param from première donnée de la tuile
+ * \param rows nombre de données de la tuile
+ * \param g espace de travail (rows x k_pad)
+ * \param ids centroïde le plus proche de chaque donnée
+ * \param cfg données de configuration
+ */
+static void gemm_assign(kmeans_t * kmeans, int from, int rows, double * g, int * ids, config_t * cfg) {
+  double dist, min_dist, second, xn;
+  const double * gp;
+  int p, c, min_cl;
+
+  kmeans->gemm(DATA_ROW(kmeans->data, from), kmeans->data->stride, rows,
+    kmeans->ct, kmeans->k_pad, cfg->nb_val, g);
+  PROF_COUNT(PROF_DIST, (uint64_t)rows * kmeans->n_clusters);
+
+  for(p = 0; p < rows; p++) {
+    gp = g + (size_t)p * kmeans->k_pad;
+    xn = kmeans->xnorm[from + p];
+    min_dist = second = HUGE_VAL;
+    min_cl = 0;
+    for(c = 0; c < kmeans->n_clusters; c++) {
+      dist = xn - 2.0 * gp[c] + kmeans->cnorm[c];
+      if(dist < 0.0)
+        dist = 0.0;
+      if(dist < min_dist) {
+        second = min_dist;
+        min_dist = dist;
+        min_cl = c;
+      } else if(dist < second)
+        second = dist;
+    }
 
-    update_centroids(kmeans, cfg);
+    if(second - min_dist <= 2.0 * kmeans->eps * (xn + kmeans->cnorm_max))
+      min_cl = find_cluster(kmeans, DATA_ROW(kmeans->data, from + p), cfg);
+    ids[p] = min_cl;
   }
 }
 
-/** \brief Affiche les clusters de KMeans.
+/** \brief Calcule la norme au carré des données d'un bloc
+ * (exécuté par un thread).
  *
  * \param kmeans modèle KMeans
+ * \param b numéro du bloc
  * \param cfg données de configuration
+ * \param arg inutilisé
  */
-void print_cluster(kmeans_t * kmeans, data_t * data, config_t * cfg) {
-  int i, d;
-  for(i = 0; i < kmeans->data_sz; i++) {
-    for(d = 0; d < cfg->nb_val; d++)
-      printf("%.1f,", kmeans->points[i].data.v[d]);
-    printf("Iris-%d (%s)\n", kmeans->points[i].cluster_id, data[i].label);
+static void norm_task(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  kblock_t * bl = &kmeans->blocks[b];
+  const ml_real_t * v;
+  double sum;
+  int i, j;
+  (void)arg;
+
+  for(i = bl->from; i < bl->to; i++) {
+    v = DATA_ROW(kmeans->data, i);
+    for(sum = 0.0, j = 0; j < cfg->nb_val; j++)
+      sum += (double)v[j] * v[j];
+    kmeans->xnorm[i] = sum;
   }
 }
 
-/** \brief Libère le modèle KMeans.
+/** \brief Transpose les centroïdes en panneaux de GEMM_NR colonnes
+ * (en double) et calcule leur norme au carré. Les colonnes de remplissage ont une
+ * norme infinie et ne sont jamais choisies.
  *
  * \param kmeans modèle KMeans
+ * \param cfg données de configuration
  */
-void free_kmeans(kmeans_t * kmeans) {
+static void gemm_centroids(kmeans_t * kmeans, config_t * cfg) {
+  const ml_real_t * c;
+  double sum;
+  int cl, j;
+
+  kmeans->cnorm_max = 0.0;
+  for(cl = 0; cl < kmeans->k_pad; cl++) {
+    if(cl >= kmeans->n_clusters) {
+      for(j = 0; j < cfg->nb_val; j++)
+        CT(kmeans, cfg->nb_val, j, cl) = 0.0;
+      kmeans->cnorm[cl] = HUGE_VAL;
+      continue;
+    }
+    c = CENTROID(kmeans, cl);
+    for(sum = 0.0, j = 0; j < cfg->nb_val; j++) {
+      CT(kmeans, cfg->nb_val, j, cl) = c[j];
+      sum += (double)c[j] * c[j];
+    }
+    kmeans->cnorm[cl] = sum;
+    if(sum > kmeans->cnorm_max)
+      kmeans->cnorm_max = sum;
+  }
+}
+
+/** \brief Prépare l'affectation par produits scalaires (ALGO_GEMM):
+ * normes des données (une fois, en parallèle) et centroïdes transposés.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void init_gemm(kmeans_t * kmeans, config_t * cfg) {
+  if(cfg->algo != ALGO_GEMM)
+    return;
+
+  if(!kmeans->xnorm) {
+    kmeans->k_pad = (kmeans->n_clusters + GEMM_NR - 1) / GEMM_NR * GEMM_NR;
+    kmeans->xnorm = (double *)malloc((size_t)kmeans->data_sz * sizeof(*kmeans->xnorm));
+    kmeans->ct = (double *)malloc((size_t)cfg->nb_val * kmeans->k_pad * sizeof(*kmeans->ct));
+    kmeans->cnorm = (double *)malloc(kmeans->k_pad * sizeof(*kmeans->cnorm));
+    if(!kmeans->xnorm || !kmeans->ct || !kmeans->cnorm) {
+      fprintf(stderr, "Can't allocate the norms of %d data\n", kmeans->data_sz);
+      exit(1);
+    }
+    run_blocks(kmeans, cfg, norm_task, NULL);
+    gemm_kernel(kmeans);
+  }
+  gemm_centroids(kmeans, cfg);
+}
+
+/** \brief Affecte les données d'un bloc à leur centroïde le plus
+ * proche en accumulant la somme et l'effectif de chaque cluster.
+ *
+ * \param kmeans modèle KMeans
+ * \param bl bloc de données
+ * \param cfg données de configuration
+ */
+static void assign_block(kmeans_t * kmeans, kblock_t * bl, config_t * cfg) {
+  int i, cluster_id, changed = 0, ids[KMEANS_TILE];
+  int gemm = cfg->algo == ALGO_GEMM && kmeans->xnorm;
+  double * g = NULL;
+  const ml_real_t * v;
+
+  if(gemm) {
+    g = (double *)malloc((size_t)KMEANS_TILE * kmeans->k_pad * sizeof(*g));
+    assert(g);
+  }
+
+  memset(bl->sums, 0, (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*bl->sums));
+  memset(bl->counts, 0, kmeans->n_clusters * sizeof(*bl->counts));
+  for(i = bl->from; i < bl->to; i++) {
+    v = DATA_ROW(kmeans->data, i);
+    if(gemm && !((i - bl->from) % KMEANS_TILE))
+      gemm_assign(kmeans, i, bl->to - i < KMEANS_TILE ? bl->to - i : KMEANS_TILE, g, ids, cfg);
+    cluster_id = gemm ? ids[(i - bl->from) % KMEANS_TILE] : assign_point(kmeans, i, v, cfg);
+    if(kmeans->cluster_id[i] != cluster_id) {
+      kmeans->cluster_id[i] = cluster_id;
+      changed++;
+    }
+    add_weighted(bl->sums + (size_t)cluster_id * kmeans->stride, v, WEIGHT(kmeans, i), cfg->nb_val);
+    bl->counts[cluster_id] += WEIGHT(kmeans, i);
+  }
+  bl->changed = changed;
+  PROF_COUNT(PROF_REASSIGN, changed);
+  free(g);
+}
+
+/** \brief Réduit les sommes et effectifs partiels des blocs,
+ * dans l'ordre des blocs.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ *
+ * \return le nombre de changements de cluster
+ */
+static int reduce_blocks(kmeans_t * kmeans, config_t * cfg) {
+  int b, cl, i, changed = 0;
+  double * sum;
+
+  memset(kmeans->sums, 0, (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->sums));
+  memset(kmeans->counts, 0, kmeans->n_clusters * sizeof(*kmeans->counts));
+  for(b = 0; b < kmeans->n_blocks; b++) {
+    kblock_t * bl = &kmeans->blocks[b];
+    changed += bl->changed;
+    for(cl = 0; cl < kmeans->n_clusters; cl++) {
+      if(!bl->counts[cl])
+        continue;
+      kmeans->counts[cl] += bl->counts[cl];
+      sum = bl->sums + (size_t)cl * kmeans->stride;
+      for(i = 0; i < cfg->nb_val; i++)
+        SUM(kmeans, cl)[i] += sum[i];
+    }
+  }
+  return changed;
+}
+
+/** \brief Boucle d'un thread du clustering: à chaque itération,
+ * le thread affecte ses blocs (les blocs b tels que b modulo
+ * n_threads vaut son numéro), puis le thread 0 réduit les blocs,
+ * met à jour les centroïdes et décide de l'arrêt pendant que les
+ * autres attendent.
+ *
+ * \param arg thread (worker_t)
+ *
+ * \return NULL
+ */
+static void * cluster_worker(void * arg) {
+  worker_t * w = (worker_t *)arg;
+  kmeans_t * kmeans = w->kmeans;
+  int it, b, changed, last = 0;
+
+  for(it = 0; it < w->cfg->n_iters; it++) {
+    PROF_BEGIN(assign, "assign");
+    for(b = w->id; b < kmeans->n_blocks; b += kmeans->n_threads)
+      assign_block(kmeans, &kmeans->blocks[b], w->cfg);
+    PROF_END(assign);
+    pthread_barrier_wait(w->barrier);
+
+    if(!w->id) {
+      changed = reduce_blocks(kmeans, w->cfg);
+      kmeans->shift = 0.0;
+      *w->done = !changed || last;
+      if(!*w->done) {
+        memcpy(kmeans->prev, kmeans->centroids,
+          (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->prev));
+        update_centroids(kmeans, w->cfg);
+        kmeans->shift = centroid_shift(kmeans, w->cfg);
+        if(kmeans->upper) {
+          move_bounds(kmeans, w->cfg);
+          kmeans->bounded = 1;
+        }
+        if(kmeans->xnorm)
+          gemm_centroids(kmeans, w->cfg);
+        // seuil atteint: une dernière affectation aux centroïdes finaux
+        last = w->cfg->tol > 0.0 && kmeans->shift <= kmeans->tol;
+      }
+      if(w->cfg->verbose)
+        fprintf(stderr, "iteration %d: %d reassignments, shift %g\n", it + 1, changed, kmeans->shift);
+    }
+    pthread_barrier_wait(w->barrier);
+
+    if(*w->done)
+      break;
+  }
+  return NULL;
+}
+
+/** \brief Tire un indice i avec une probabilité proportionnelle
+ * à p[i].w[i], à partir d'un réel u uniforme dans [0, somme des
+ * p[i].w[i]). Les erreurs d'arrondi ne peuvent pas faire tirer un
+ * poids nul.
+ *
+ * \param p poids (au moins un est non nul)
+ * \param w multiplicateurs entiers positifs des poids (NULL: 1)
+ * \param n nombre de poids
+ * \param u réel uniforme, diminué des poids qui précèdent
+ * l'indice tiré
+ *
+ * \return l'indice tiré
+ */
+static int draw(const double * p, const int * w, int n, double * u) {
+  double pw;
+  int i;
+  for(i = 0; i < n - 1; i++) {
+    pw = w ? w[i] * p[i] : p[i];
+    if(*u < pw)
+      break;
+    *u -= pw;
+  }
+  while(!(p[i] > 0.0))
+    i--;
+  return i;
+}
+
+/** \brief Tire une donnée avec une probabilité proportionnelle à
+ * sa distance au carré au candidat le plus proche (D²), multipliée
+ * par son poids, d'abord le bloc puis la donnée dans le bloc: le
+ * tirage ne dépend pas du nombre de threads. Sans distance non nulle
+ * (aucun candidat, ou toutes les données confondues avec un
+ * candidat), le tirage ne dépend que des poids (rand_point).
+ *
+ * \param kmeans modèle KMeans
+ * \param s état de l'initialisation
+ *
+ * \return l'indice de la donnée tirée
+ */
+static int draw_point(kmeans_t * kmeans, seeding_t * s) {
+  double total = 0.0, u;
+  kblock_t * bl;
+  int b;
+
+  for(b = 0; b < kmeans->n_blocks; b++)
+    total += s->psi[b];
+  if(!(total > 0.0))
+    return rand_point(kmeans);
+
+  u = rng_uniform(rng_local()) * total;
+  bl = &kmeans->blocks[draw(s->psi, NULL, kmeans->n_blocks, &u)];
+  return bl->from + draw(s->dist + bl->from,
+    kmeans->data->weight ? kmeans->data->weight + bl->from : NULL, bl->to - bl->from, &u);
+}
+
+/** \brief Ajoute une donnée aux candidats.
+ *
+ * \param s état de l'initialisation
+ * \param i indice de la donnée
+ */
+static void add_candidate(seeding_t * s, int i) {
+  if(s->n_cand == s->cap) {
+    s->cap *= 2;
+    s->cand = (int *)realloc(s->cand, s->cap * sizeof(*s->cand));
+    assert(s->cand);
+  }
+  s->cand[s->n_cand++] = i;
+}
+
+/** \brief Met à jour la distance des données d'un bloc au candidat
+ * le plus proche avec les candidats ajoutés depuis la dernière mise
+ * à jour, ainsi que la somme des distances du bloc (pondérées).
+ *
+ * \param kmeans modèle KMeans
+ * \param b numéro du bloc
+ * \param cfg données de configuration
+ * \param arg état de l'initialisation (seeding_t)
+ */
+static void update_dist(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  seeding_t * s = (seeding_t *)arg;
+  kblock_t * bl = &kmeans->blocks[b];
+  const ml_real_t * v;
+  double dist, psi = 0.0;
+  int i, c;
+
+  for(i = bl->from; i < bl->to; i++) {
+    v = DATA_ROW(kmeans->data, i);
+    for(c = s->first; c < s->n_cand; c++) {
+      dist = sq_l2_dist(DATA_ROW(kmeans->data, s->cand[c]), v, cfg->nb_val);
+      if(dist < s->dist[i]) {
+        s->dist[i] = dist;
+        if(s->near)
+          s->near[i] = c;
+      }
+    }
+    psi += WEIGHT(kmeans, i) * s->dist[i];
+  }
+  s->psi[b] = psi;
+}
+
+/** \brief Tire indépendamment chaque donnée d'un bloc avec la
+ * probabilité l.w.D²/psi (k-means||), w étant son poids. Le générateur de chaque bloc
+ * est dérivé de la graine du tour et du numéro du bloc.
+ *
+ * \param kmeans modèle KMeans
+ * \param b numéro du bloc
+ * \param cfg données de configuration
+ * \param arg état de l'initialisation (seeding_t)
+ */
+static void sample_block(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  seeding_t * s = (seeding_t *)arg;
+  kblock_t * bl = &kmeans->blocks[b];
+  double l = (double)KMEANS_OVERSAMPLING * kmeans->n_clusters;
+  rng_t r;
+  int i;
+
+  rng_init(&r, s->round_seed, b);
+  s->n_picked[b] = 0;
+  for(i = bl->from; i < bl->to; i++) {
+    if(rng_uniform(&r) * s->psi_sum >= l * WEIGHT(kmeans, i) * s->dist[i])
+      continue;
+    if(s->n_picked[b] == s->picked_cap[b]) {
+      s->picked_cap[b] = s->picked_cap[b] ? 2 * s->picked_cap[b] : 64;
+      s->picked[b] = (int *)realloc(s->picked[b], s->picked_cap[b] * sizeof(*s->picked[b]));
+      assert(s->picked[b]);
+    }
+    s->picked[b][s->n_picked[b]++] = i;
+  }
+}
+
+/** \brief Ajoute des candidats par tirage D² (k-means++) jusqu'à
+ * en avoir n_clusters.
+ *
+ * \param kmeans modèle KMeans
+ * \param s état de l'initialisation
+ * \param cfg données de configuration
+ */
+static void pp_seeds(kmeans_t * kmeans, seeding_t * s, config_t * cfg) {
+  while(s->n_cand < kmeans->n_clusters) {
+    add_candidate(s, draw_point(kmeans, s));
+    if(s->n_cand < kmeans->n_clusters)
+      run_blocks(kmeans, cfg, update_dist, s);
+    s->first = s->n_cand;
+  }
+}
+
+/** \brief Choisit n_clusters candidats parmi ceux de k-means||, par
+ * un k-means++ pondéré par le nombre de données dont chaque
+ * candidat est le plus proche. Les candidats choisis sont placés
+ * au début de s->cand.
+ *
+ * \param kmeans modèle KMeans
+ * \param s état de l'initialisation
+ * \param cfg données de configuration
+ */
+static void recluster_seeds(kmeans_t * kmeans, seeding_t * s, config_t * cfg) {
+  int m = s->n_cand, i, c, j;
+  double * w = (double *)calloc(m, sizeof(*w));
+  double * dist = (double *)malloc(m * sizeof(*dist));
+  double * p = (double *)malloc(m * sizeof(*p));
+  double total, d, u;
+  assert(w && dist && p);
+
+  for(i = 0; i < kmeans->data_sz; i++)
+    w[s->near[i]] += WEIGHT(kmeans, i);
+  for(c = 0; c < m; c++)
+    dist[c] = HUGE_VAL;
+
+  for(j = 0; j < kmeans->n_clusters; j++) {
+    total = 0.0;
+    for(c = j; c < m; c++)
+      total += p[c] = j ? w[c] * dist[c] : w[c];
+
+    // candidats restants tous confondus avec un candidat choisi
+    if(!(total > 0.0))
+      c = j + rand_int(m - j);
+    else {
+      u = rng_uniform(rng_local()) * total;
+      c = j + draw(p + j, NULL, m - j, &u);
+    }
+
+    // les candidats choisis sont rangés au début
+    i = s->cand[c]; s->cand[c] = s->cand[j]; s->cand[j] = i;
+    d = w[c]; w[c] = w[j]; w[j] = d;
+    d = dist[c]; dist[c] = dist[j]; dist[j] = d;
+
+    for(c = j + 1; c < m; c++) {
+      d = sq_l2_dist(DATA_ROW(kmeans->data, s->cand[j]),
+        DATA_ROW(kmeans->data, s->cand[c]), cfg->nb_val);
+      if(d < dist[c])
+        dist[c] = d;
+    }
+  }
+  s->n_cand = kmeans->n_clusters;
+
+  free(p);
+  free(dist);
+  free(w);
+}
+
+/** \brief Initialisation k-means|| (Bahmani et al.): à partir d'une
+ * donnée tirée au hasard, chaque tour tire en parallèle chaque
+ * donnée avec une probabilité proportionnelle à D², soit environ
+ * KMEANS_OVERSAMPLING.k candidats par tour, puis les candidats sont
+ * réduits à k par un k-means++ pondéré.
+ *
+ * \param kmeans modèle KMeans
+ * \param s état de l'initialisation
+ * \param cfg données de configuration
+ */
+static void par_seeds(kmeans_t * kmeans, seeding_t * s, config_t * cfg) {
+  int r, b, i;
+
+  s->near = (int *)malloc(kmeans->data_sz * sizeof(*s->near));
+  s->picked = (int **)calloc(kmeans->n_blocks, sizeof(*s->picked));
+  s->n_picked = (int *)calloc(kmeans->n_blocks, sizeof(*s->n_picked));
+  s->picked_cap = (int *)calloc(kmeans->n_blocks, sizeof(*s->picked_cap));
+  assert(s->near && s->picked && s->n_picked && s->picked_cap);
+
+  add_candidate(s, rand_point(kmeans));
+  run_blocks(kmeans, cfg, update_dist, s);
+  s->first = s->n_cand;
+
+  for(r = 0; r < KMEANS_PAR_ROUNDS; r++) {
+    for(s->psi_sum = 0.0, b = 0; b < kmeans->n_blocks; b++)
+      s->psi_sum += s->psi[b];
+    if(!(s->psi_sum > 0.0))
+      break;
+
+    s->round_seed = rng_next(rng_local());
+    run_blocks(kmeans, cfg, sample_block, s);
+    for(b = 0; b < kmeans->n_blocks; b++)
+      for(i = 0; i < s->n_picked[b]; i++)
+        add_candidate(s, s->picked[b][i]);
+
+    run_blocks(kmeans, cfg, update_dist, s);
+    s->first = s->n_cand;
+  }
+
+  // trop peu de candidats (données peu nombreuses ou confondues)
+  if(s->n_cand <= kmeans->n_clusters)
+    pp_seeds(kmeans, s, cfg);
+  else
+    recluster_seeds(kmeans, s, cfg);
+
+  for(b = 0; b < kmeans->n_blocks; b++)
+    free(s->picked[b]);
+  free(s->picked_cap);
+  free(s->n_picked);
+  free(s->picked);
+  free(s->near);
+}
+
+/** \brief Choisit n_clusters données distinctes, uniformément ou
+ * selon leur poids (rand_point).
+ *
+ * \param kmeans modèle KMeans
+ * \param seeds indices des données choisies
+ */
+static void random_seeds(kmeans_t * kmeans, int * seeds) {
+  int r, i, c = 0;
+  for(i = 0; i < kmeans->n_clusters; i++)
+    seeds[i] = -1;
+
+  do {
+    r = rand_point(kmeans);
+
+    while(1) {
+      if(~get_index(seeds, c, r, kmeans->n_clusters)) r = rand_point(kmeans);
+      else break;
+    }
+
+    seeds[c++] = r;
+  } while(c < kmeans->n_clusters);
+}
+
+/** \brief Initialise les centroïdes pour le KMeans selon
+ * cfg->init (INIT_KMEANSPP, INIT_KMEANS_PAR ou INIT_RANDOM): les
+ * données choisies sont copiées dans les centroïdes.
+ *
+ * \param kmeans modèle KMeans
+ * \param data données
+ * \param cfg données de configuration
+ */
+static void init_centroids(kmeans_t * kmeans, data_t * data, config_t * cfg) {
+  PROF_BEGIN(seed, "init_centroids");
+  seeding_t s;
+  int i;
+
+  if(posix_memalign((void **)&kmeans->centroids, DATA_ALIGN,
+      (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->centroids))) {
+    fprintf(stderr, "Can't allocate %d centroids\n", kmeans->n_clusters);
+    exit(1);
+  }
+
+  memset(&s, 0, sizeof(s));
+  s.cap = kmeans->n_clusters;
+  s.cand = (int *)malloc(s.cap * sizeof(*s.cand));
+  assert(s.cand);
+
+  if(cfg->init == INIT_RANDOM) {
+    random_seeds(kmeans, s.cand);
+    s.n_cand = kmeans->n_clusters;
+  } else {
+    s.dist = (double *)malloc(kmeans->data_sz * sizeof(*s.dist));
+    s.psi = (double *)calloc(kmeans->n_blocks, sizeof(*s.psi));
+    assert(s.dist && s.psi);
+    for(i = 0; i < kmeans->data_sz; i++)
+      s.dist[i] = HUGE_VAL;
+
+    if(cfg->init == INIT_KMEANS_PAR)
+      par_seeds(kmeans, &s, cfg);
+    else
+      pp_seeds(kmeans, &s, cfg);
+
+    free(s.psi);
+    free(s.dist);
+  }
+
+  for(i = 0; i < kmeans->n_clusters; i++)
+    memcpy(CENTROID(kmeans, i), DATA_ROW(data, s.cand[i]), kmeans->stride * sizeof(*kmeans->centroids));
+
+  free(s.cand);
+  PROF_END(seed);
+}
+
+/** \brief Majore largement l'erreur relative d'une distance
+ * calculée.
+ *
+ * \param cfg données de configuration
+ *
+ * \return la marge relative des distances
+ */
+static double dist_eps(config_t * cfg) {
+#ifdef ML_FLOAT
+  return 4.0 * (cfg->nb_val + 16) * FLT_EPSILON;
+#else
+  return 4.0 * (cfg->nb_val + 16) * DBL_EPSILON;
+#endif
+}
+
+/** \brief Initialise le modèle KMeans: cluster,
+ * centroïdes et points.
+ *
+ * \param data données
+ * \param cfg données de configuration
+ *
+ * \return le modèle KMeans.
+ */
+kmeans_t * init_kmeans(data_t * data, config_t * cfg) {
+  kmeans_t * kmeans = (kmeans_t *)malloc(sizeof(*kmeans));
+  assert(kmeans);
+
+  if(cfg->n_clusters < 1 || cfg->n_clusters > cfg->data_sz) {
+    fprintf(stderr, "Can't make %d clusters from %d data\n", cfg->n_clusters, cfg->data_sz);
+    exit(1);
+  }
+
+  kmeans->n_clusters = cfg->n_clusters;
+  kmeans->data_sz = cfg->data_sz;
+  kmeans->stride = data->stride;
+  kmeans->upper = kmeans->half_cc = kmeans->half_min = kmeans->delta = NULL;
+  kmeans->lower = kmeans->delta_f = NULL;
+  kmeans->prev = NULL;
+  kmeans->xnorm = kmeans->ct = kmeans->cnorm = NULL;
+  kmeans->cum_weight = NULL;
+
+  kmeans->eps = dist_eps(cfg);
+  init_points(kmeans, data, cfg->data_sz);
+
+  // données pondérées: poids cumulés pour les tirages (rand_point)
+  if(data->weight) {
+    int i;
+    kmeans->cum_weight = (double *)malloc(kmeans->data_sz * sizeof(*kmeans->cum_weight));
+    assert(kmeans->cum_weight);
+    for(i = 0; i < kmeans->data_sz; i++)
+      kmeans->cum_weight[i] = (i ? kmeans->cum_weight[i - 1] : 0.0) + data->weight[i];
+  }
+
+  kmeans->sums = (double *)malloc((size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->sums));
+  kmeans->counts = (int *)malloc(kmeans->n_clusters * sizeof(*kmeans->counts));
+  assert(kmeans->sums && kmeans->counts);
+
+  init_blocks(kmeans, cfg);
+  init_centroids(kmeans, data, cfg);
+
+  return kmeans;
+}
+
+/** \brief Calcule la somme des valeurs de chaque dimension d'un
+ * bloc (arg NULL) ou la somme des carrés de leurs écarts à la
+ * moyenne arg, pondérées par le poids des données, dans les
+ * premières valeurs des sommes du bloc (exécuté par un thread).
+ *
+ * \param kmeans modèle KMeans
+ * \param b numéro du bloc
+ * \param cfg données de configuration
+ * \param arg moyenne de chaque dimension, ou NULL
+ */
+static void moment_task(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  kblock_t * bl = &kmeans->blocks[b];
+  const double * mean = (const double *)arg;
+  const ml_real_t * v;
+  double c;
+  int i, j, w;
+
+  memset(bl->sums, 0, cfg->nb_val * sizeof(*bl->sums));
+  for(i = bl->from; i < bl->to; i++)
+    for(v = DATA_ROW(kmeans->data, i), w = WEIGHT(kmeans, i), j = 0; j < cfg->nb_val; j++) {
+      c = mean ? v[j] - mean[j] : v[j];
+      bl->sums[j] += w * (mean ? c * c : c);
+    }
+}
+
+/** \brief Calcule la variance moyenne des dimensions des données,
+ * en deux passes parallèles (moyennes, puis écarts à la moyenne)
+ * dont les sommes des blocs sont ajoutées dans l'ordre des blocs.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ *
+ * \return la moyenne des variances des dimensions
+ */
+static double data_variance(kmeans_t * kmeans, config_t * cfg) {
+  double * mean = (double *)calloc(cfg->nb_val, sizeof(*mean)), var = 0.0;
+  double n = kmeans->cum_weight ? kmeans->cum_weight[kmeans->data_sz - 1] : kmeans->data_sz;
+  int b, j, pass;
+  assert(mean);
+
+  for(pass = 0; pass < 2; pass++) {
+    run_blocks(kmeans, cfg, moment_task, pass ? mean : NULL);
+    for(j = 0; j < cfg->nb_val; j++) {
+      double sum = 0.0;
+      for(b = 0; b < kmeans->n_blocks; b++)
+        sum += kmeans->blocks[b].sums[j];
+      if(pass)
+        var += sum / n;
+      else
+        mean[j] = sum / n;
+    }
+  }
+
+  free(mean);
+  return var / cfg->nb_val;
+}
+
+/** \brief Algorithme de Lloyd: chaque itération affecte
+ * les données à leur centroïde le plus proche en accumulant,
+ * dans le même passage, la somme et l'effectif de chaque cluster
+ * par bloc, puis recalcule les centroïdes en O(k.d). Les blocs
+ * sont répartis sur kmeans->n_threads threads. L'algorithme s'arrête
+ * quand plus aucune donnée ne change de cluster ou, si cfg->tol est
+ * non nul, après une dernière affectation quand le déplacement des
+ * centroïdes passe sous cfg->tol fois la variance moyenne des données.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void lloyd(kmeans_t * kmeans, config_t * cfg) {
+  int i, done = 0;
+  pthread_barrier_t barrier;
+  pthread_t * threads = (pthread_t *)malloc(kmeans->n_threads * sizeof(*threads));
+  worker_t * workers = (worker_t *)malloc(kmeans->n_threads * sizeof(*workers));
+  assert(threads && workers);
+
+  if(!kmeans->prev && posix_memalign((void **)&kmeans->prev, DATA_ALIGN,
+      (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->prev))) {
+    fprintf(stderr, "Can't allocate %d centroids\n", kmeans->n_clusters);
+    exit(1);
+  }
+  kmeans->tol = cfg->tol > 0.0 ? cfg->tol * data_variance(kmeans, cfg) : 0.0;
+  init_bounds(kmeans, cfg);
+  init_gemm(kmeans, cfg);
+
+  pthread_barrier_init(&barrier, NULL, kmeans->n_threads);
+  for(i = 0; i < kmeans->n_threads; i++) {
+    workers[i].kmeans = kmeans;
+    workers[i].cfg = cfg;
+    workers[i].id = i;
+    workers[i].done = &done;
+    workers[i].barrier = &barrier;
+  }
+
+  for(i = 1; i < kmeans->n_threads; i++)
+    if(pthread_create(&threads[i], NULL, cluster_worker, &workers[i])) {
+      fprintf(stderr, "Can't create thread\n");
+      exit(1);
+    }
+  cluster_worker(&workers[0]);
+  for(i = 1; i < kmeans->n_threads; i++)
+    pthread_join(threads[i], NULL);
+
+  pthread_barrier_destroy(&barrier);
+  free(workers);
+  free(threads);
+}
+
+/** \brief Affecte les données d'un bloc (exécuté par un thread).
+ *
+ * \param kmeans modèle KMeans
+ * \param b numéro du bloc
+ * \param cfg données de configuration
+ * \param arg inutilisé
+ */
+static void assign_task(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  (void)arg;
+  assign_block(kmeans, &kmeans->blocks[b], cfg);
+}
+
+/** \brief Mini-batch k-means (Sculley): chaque itération tire
+ * cfg->batch_sz données au hasard (selon leur poids), les affecte aux centroïdes
+ * courants puis déplace chaque centroïde vers la moyenne de ses
+ * données avec un taux d'apprentissage 1/v, v étant le nombre de
+ * données qu'il a reçues depuis le début. Le calcul par centroïde
+ * (somme du mini-batch, puis moyenne pondérée) équivaut aux mises
+ * à jour donnée par donnée et ne dépend pas de leur ordre.
+ * L'apprentissage s'arrête après KMEANS_MB_PATIENCE mini-batchs
+ * consécutifs dont le déplacement des centroïdes (somme des carrés)
+ * reste sous cfg->batch_tol fois la variance moyenne des données,
+ * estimée sur le premier mini-batch. Les données sont ensuite
+ * toutes affectées en parallèle.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void minibatch(kmeans_t * kmeans, config_t * cfg) {
+  PROF_BEGIN(minibatch, "minibatch");
+  int n = cfg->batch_sz < kmeans->data_sz ? cfg->batch_sz : kmeans->data_sz;
+  int it, i, j, cl, calm = 0;
+  int * batch = (int *)malloc(n * sizeof(*batch));
+  int * batch_id = (int *)malloc(n * sizeof(*batch_id));
+  double * seen = (double *)calloc(kmeans->n_clusters, sizeof(*seen));
+  double tol = 0.0, shift, c, mean, var;
+  const ml_real_t * v;
+  assert(batch && batch_id && seen);
+
+  for(it = 0; it < cfg->n_iters; it++) {
+    for(j = 0; j < n; j++)
+      batch[j] = rand_point(kmeans);
+
+    if(!it) {
+      for(i = 0; i < cfg->nb_val; i++) {
+        for(mean = 0.0, j = 0; j < n; j++)
+          mean += DATA_ROW(kmeans->data, batch[j])[i];
+        mean /= n;
+        for(var = 0.0, j = 0; j < n; j++) {
+          c = DATA_ROW(kmeans->data, batch[j])[i] - mean;
+          var += c * c;
+        }
+        tol += var / n;
+      }
+      tol *= cfg->batch_tol / cfg->nb_val;
+    }
+
+    memset(kmeans->sums, 0, (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->sums));
+    memset(kmeans->counts, 0, kmeans->n_clusters * sizeof(*kmeans->counts));
+    for(j = 0; j < n; j++) {
+      v = DATA_ROW(kmeans->data, batch[j]);
+      batch_id[j] = find_cluster(kmeans, v, cfg);
+    }
+    for(j = 0; j < n; j++) {
+      add_point(SUM(kmeans, batch_id[j]), DATA_ROW(kmeans->data, batch[j]), cfg->nb_val);
+      kmeans->counts[batch_id[j]]++;
+    }
+
+    shift = 0.0;
+    for(cl = 0; cl < kmeans->n_clusters; cl++) {
+      if(!kmeans->counts[cl])
+        continue;
+      seen[cl] += kmeans->counts[cl];
+      for(i = 0; i < cfg->nb_val; i++) {
+        c = CENTROID(kmeans, cl)[i];
+        c += (SUM(kmeans, cl)[i] - kmeans->counts[cl] * c) / seen[cl];
+        shift += (c - CENTROID(kmeans, cl)[i]) * (c - CENTROID(kmeans, cl)[i]);
+        CENTROID(kmeans, cl)[i] = c;
+      }
+    }
+
+    if(cfg->verbose)
+      fprintf(stderr, "batch %d: shift %g\n", it + 1, shift);
+    if(shift > tol)
+      calm = 0;
+    else if(++calm >= KMEANS_MB_PATIENCE)
+      break;
+  }
+
+  init_gemm(kmeans, cfg);
+  run_blocks(kmeans, cfg, assign_task, NULL);
+
+  free(seen);
+  free(batch_id);
+  free(batch);
+  PROF_END(minibatch);
+}
+
+/** \brief Calcule la somme des distances au carré des données
+ * d'un bloc à leur centroïde, pondérées, et l'effectif de chaque
+ * cluster dans le bloc (exécuté par un thread).
+ *
+ * \param kmeans modèle KMeans
+ * \param b numéro du bloc
+ * \param cfg données de configuration
+ * \param arg inutilisé
+ */
+static void inertia_task(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  kblock_t * bl = &kmeans->blocks[b];
+  int i;
+  (void)arg;
+
+  bl->inertia = 0.0;
+  memset(bl->counts, 0, kmeans->n_clusters * sizeof(*bl->counts));
+  for(i = bl->from; i < bl->to; i++) {
+    bl->inertia += WEIGHT(kmeans, i) * sq_l2_dist(CENTROID(kmeans, kmeans->cluster_id[i]),
+      DATA_ROW(kmeans->data, i), cfg->nb_val);
+    bl->counts[kmeans->cluster_id[i]] += WEIGHT(kmeans, i);
+  }
+}
+
+/** \brief Calcule l'inertie du modèle (somme des distances au
+ * carré des données au centroïde de leur cluster) et l'effectif de
+ * chaque cluster. Les sommes des blocs sont ajoutées dans l'ordre
+ * des blocs.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void compute_inertia(kmeans_t * kmeans, config_t * cfg) {
+  int b, cl;
+  run_blocks(kmeans, cfg, inertia_task, NULL);
+  memset(kmeans->counts, 0, kmeans->n_clusters * sizeof(*kmeans->counts));
+  for(kmeans->inertia = 0.0, b = 0; b < kmeans->n_blocks; b++) {
+    kmeans->inertia += kmeans->blocks[b].inertia;
+    for(cl = 0; cl < kmeans->n_clusters; cl++)
+      kmeans->counts[cl] += kmeans->blocks[b].counts[cl];
+  }
+}
+
+/** \brief Exécute le clustering: algorithme de Lloyd sur toutes
+ * les données, ou mini-batch k-means si cfg->batch_sz est non nul,
+ * puis calcule l'inertie.
+ *
+ * \param kmeans modèle KMeans
+ * \param data données
+ * \param cfg données de configuration
+ */
+void cluster(kmeans_t * kmeans, data_t * data, config_t * cfg) {
+  PROF_BEGIN(cluster, "cluster");
+  if(cfg->batch_sz > 0)
+    minibatch(kmeans, cfg);
+  else
+    lloyd(kmeans, cfg);
+  compute_inertia(kmeans, cfg);
+  PROF_END(cluster);
+}
+
+/** \brief Exécute les initialisations d'un thread: l'initialisation
+ * r tire ses nombres aléatoires dans le flux r, son résultat ne
+ * dépend donc ni du thread qui l'exécute ni du nombre de threads.
+ * Seul le modèle de plus faible inertie est gardé (le premier en
+ * cas d'égalité).
+ *
+ * \param arg thread (restart_t)
+ *
+ * \return NULL
+ */
+static void * run_restarts(void * arg) {
+  restart_t * t = (restart_t *)arg;
+  kmeans_t * kmeans;
+  int r;
+
+  for(r = t->id; r < t->cfg.n_init; r += t->n_runners) {
+    rng_stream(r);
+    kmeans = init_kmeans(t->data, &t->cfg);
+    cluster(kmeans, t->data, &t->cfg);
+    if(!t->best || kmeans->inertia < t->best->inertia) {
+      free_kmeans(t->best);
+      t->best = kmeans;
+      t->best_r = r;
+    } else
+      free_kmeans(kmeans);
+  }
+  return NULL;
+}
+
+/** \brief Initialise et exécute le clustering cfg->n_init fois
+ * (au moins une) et garde le modèle de plus faible inertie. Les
+ * initialisations sont exécutées en parallèle, les threads de
+ * cfg->n_threads étant répartis entre elles (au moins un chacune, le
+ * reste de la division allant aux premières); les données sont
+ * partagées en lecture seule. L'initialisation r utilise le flux
+ * aléatoire r: avec une seule initialisation, le résultat est celui
+ * de init_kmeans suivi de cluster.
+ *
+ * \param data données
+ * \param cfg données de configuration
+ *
+ * \return le meilleur modèle KMeans
+ */
+kmeans_t * fit_kmeans(data_t * data, config_t * cfg) {
+  int n_init = cfg->n_init > 1 ? cfg->n_init : 1;
+  int threads = nb_threads(cfg), n_runners = n_init < threads ? n_init : threads, i;
+  pthread_t * th = (pthread_t *)malloc(n_runners * sizeof(*th));
+  restart_t * runners = (restart_t *)calloc(n_runners, sizeof(*runners));
+  kmeans_t * best = NULL;
+  int best_r = 0;
+  assert(th && runners);
+
+  for(i = 0; i < n_runners; i++) {
+    runners[i].data = data;
+    runners[i].cfg = *cfg;
+    runners[i].cfg.n_init = n_init;
+    // le reste de la division va aux premiers runners; jamais 0
+    // thread, qui reviendrait à prendre tous les processeurs
+    runners[i].cfg.n_threads = threads / n_runners + (i < threads % n_runners);
+    if(runners[i].cfg.n_threads < 1)
+      runners[i].cfg.n_threads = 1;
+    runners[i].id = i;
+    runners[i].n_runners = n_runners;
+  }
+
+  for(i = 1; i < n_runners; i++)
+    if(pthread_create(&th[i], NULL, run_restarts, &runners[i])) {
+      fprintf(stderr, "Can't create thread\n");
+      exit(1);
+    }
+  run_restarts(&runners[0]);
+  for(i = 1; i < n_runners; i++)
+    pthread_join(th[i], NULL);
+
+  for(i = 0; i < n_runners; i++) {
+    if(!best || runners[i].best->inertia < best->inertia ||
+        (runners[i].best->inertia == best->inertia && runners[i].best_r < best_r)) {
+      free_kmeans(best);
+      best = runners[i].best;
+      best_r = runners[i].best_r;
+    } else
+      free_kmeans(runners[i].best);
+  }
+
+  free(runners);
+  free(th);
+  return best;
+}
+
+/** \brief Affecte les données d'un bloc à leur centroïde le plus
+ * proche, sans sommes ni bornes (exécuté par un thread).
+ *
+ * \param kmeans modèle KMeans
+ * \param b numéro du bloc
+ * \param cfg données de configuration
+ * \param arg inutilisé
+ */
+static void predict_task(kmeans_t * kmeans, int b, config_t * cfg, void * arg) {
+  kblock_t * bl = &kmeans->blocks[b];
+  double * g;
+  int i;
+  (void)arg;
+
+  if(!kmeans->xnorm) {
+    for(i = bl->from; i < bl->to; i++)
+      kmeans->cluster_id[i] = find_cluster(kmeans, DATA_ROW(kmeans->data, i), cfg);
+    return;
+  }
+
+  g = (double *)malloc((size_t)KMEANS_TILE * kmeans->k_pad * sizeof(*g));
+  assert(g);
+  for(i = bl->from; i < bl->to; i += KMEANS_TILE)
+    gemm_assign(kmeans, i, bl->to - i < KMEANS_TILE ? bl->to - i : KMEANS_TILE,
+      g, kmeans->cluster_id + i, cfg);
+  free(g);
+}
+
+/** \brief Affecte chaque donnée au cluster du centroïde le plus
+ * proche. Les données sont découpées en blocs répartis sur
+ * cfg->n_threads threads et affectées par tuiles si cfg->algo vaut
+ * ALGO_GEMM; le modèle n'est pas modifié.
+ *
+ * \param kmeans modèle KMeans
+ * \param data données
+ * \param cfg données de configuration
+ *
+ * \return l'identifiant du cluster de chaque donnée
+ */
+int * predict(kmeans_t * kmeans, data_t * data, config_t * cfg) {
+  PROF_BEGIN(predict, "predict");
+  kmeans_t view = *kmeans;
+
+  int * predicted = (int *)malloc(data->n * sizeof(*predicted));
+  assert(predicted);
+
+  // mêmes centroïdes, découpage et normes propres aux données
+  view.data = data;
+  view.data_sz = data->n;
+  view.cluster_id = predicted;
+  view.xnorm = view.ct = view.cnorm = NULL;
+  split_blocks(&view, cfg);
+  init_gemm(&view, cfg);
+  run_blocks(&view, cfg, predict_task, NULL);
+
+  free(view.xnorm);
+  free(view.ct);
+  free(view.cnorm);
+  free(view.blocks);
+  PROF_END(predict);
+  return predicted;
+}
+
+/** \brief Replace les centroïdes des clusters touchés par de
+ * nouvelles données à la moyenne de leurs données anciennes (résumées
+ * par le centroïde et l'effectif de départ) et nouvelles.
+ *
+ * \param kmeans modèle KMeans
+ * \param data nouvelles données
+ * \param ids cluster de chaque nouvelle donnée
+ * \param base centroïdes de départ
+ * \param base_n effectifs de départ
+ * \param sums espace de travail (n_clusters x stride)
+ * \param n espace de travail (n_clusters)
+ * \param cfg données de configuration
+ *
+ * \return le déplacement des centroïdes (somme des carrés)
+ */
+static double fold_clusters(kmeans_t * kmeans, data_t * data, const int * ids,
+    const ml_real_t * base, const int * base_n, double * sums, int * n, config_t * cfg) {
+  double shift = 0.0, c;
+  long total;
+  int i, j, cl;
+
+  memset(sums, 0, (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*sums));
+  memset(n, 0, kmeans->n_clusters * sizeof(*n));
+  for(i = 0; i < data->n; i++) {
+    add_point(sums + (size_t)ids[i] * kmeans->stride, DATA_ROW(data, i), cfg->nb_val);
+    n[ids[i]]++;
+  }
+
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    // clusters qui ne reçoivent et ne perdent aucune nouvelle donnée
+    if(!n[cl] && kmeans->counts[cl] == base_n[cl])
+      continue;
+    total = (long)base_n[cl] + n[cl];
+    if(total > INT_MAX) {
+      fprintf(stderr, "Too many data in cluster %d\n", cl);
+      exit(1);
+    }
+    kmeans->counts[cl] = total;
+    if(!total) {
+      memcpy(CENTROID(kmeans, cl), base + (size_t)cl * kmeans->stride,
+        kmeans->stride * sizeof(*kmeans->centroids));
+      continue;
+    }
+    for(j = 0; j < cfg->nb_val; j++) {
+      c = (base_n[cl] * (double)base[(size_t)cl * kmeans->stride + j] + sums[(size_t)cl * kmeans->stride + j]) / total;
+      shift += (c - CENTROID(kmeans, cl)[j]) * (c - CENTROID(kmeans, cl)[j]);
+      CENTROID(kmeans, cl)[j] = c;
+    }
+  }
+  return shift;
+}
+
+/** \brief Ajoute de nouvelles données à un modèle (démarrage à
+ * chaud): elles sont affectées aux centroïdes courants, puis chaque
+ * centroïde touché devient la moyenne de ses données anciennes et
+ * nouvelles, c = (N.c + somme des nouvelles) / (N + n), les données
+ * anciennes étant résumées par le centroïde et l'effectif N du
+ * modèle. Jusqu'à cfg->warm_iters passes de Lloyd réaffectent
+ * ensuite les seules nouvelles données et ne recalculent que les
+ * clusters qu'elles touchent. L'inertie du modèle est mise à jour
+ * par une estimation: ancienne inertie, plus N.||déplacement||² pour
+ * chaque cluster, plus les distances des nouvelles données. Elle
+ * n'est exacte que si chaque centroïde enregistré est la moyenne de
+ * ses N données, ce qui n'est pas le cas d'un modèle appris par
+ * mini-batchs (BATCH_SIZE) ou arrêté par TOL ou N_ITERS.
+ *
+ * \param kmeans modèle KMeans (chargé par load_kmeans)
+ * \param data nouvelles données
+ * \param cfg données de configuration
+ *
+ * \return le cluster de chaque nouvelle donnée, celui avec lequel
+ * elle a été ajoutée au modèle
+ */
+int * fold_in(kmeans_t * kmeans, data_t * data, config_t * cfg) {
+  PROF_BEGIN(fold, "fold_in");
+  size_t csz = (size_t)kmeans->n_clusters * kmeans->stride;
+  ml_real_t * base;
+  int * base_n = (int *)malloc(kmeans->n_clusters * sizeof(*base_n));
+  int * n = (int *)malloc(kmeans->n_clusters * sizeof(*n));
+  double * sums = (double *)malloc(csz * sizeof(*sums)), shift;
+  int * ids, * next, it, i, changed, cl;
+  assert(base_n && n && sums);
+
+  if(posix_memalign((void **)&base, DATA_ALIGN, csz * sizeof(*base))) {
+    fprintf(stderr, "Can't allocate %d centroids\n", kmeans->n_clusters);
+    exit(1);
+  }
+  memcpy(base, kmeans->centroids, csz * sizeof(*base));
+  memcpy(base_n, kmeans->counts, kmeans->n_clusters * sizeof(*base_n));
+
+  ids = predict(kmeans, data, cfg);
+  shift = fold_clusters(kmeans, data, ids, base, base_n, sums, n, cfg);
+  if(cfg->verbose)
+    fprintf(stderr, "fold-in: %d data, shift %g\n", data->n, shift);
+
+  for(it = 0; it < cfg->warm_iters; it++) {
+    next = predict(kmeans, data, cfg);
+    for(changed = 0, i = 0; i < data->n; i++)
+      changed += next[i] != ids[i];
+    free(ids);
+    ids = next;
+    if(!changed)
+      break;
+    shift = fold_clusters(kmeans, data, ids, base, base_n, sums, n, cfg);
+    if(cfg->verbose)
+      fprintf(stderr, "iteration %d: %d reassignments, shift %g\n", it + 1, changed, shift);
+  }
+
+  for(cl = 0; cl < kmeans->n_clusters; cl++)
+    kmeans->inertia += base_n[cl] * sq_l2_dist(base + (size_t)cl * kmeans->stride,
+      CENTROID(kmeans, cl), cfg->nb_val);
+  for(i = 0; i < data->n; i++)
+    kmeans->inertia += sq_l2_dist(CENTROID(kmeans, ids[i]), DATA_ROW(data, i), cfg->nb_val);
+
+  free(sums);
+  free(n);
+  free(base_n);
+  free(base);
+  PROF_END(fold);
+  return ids;
+}
+
+/** \brief Enregistre le modèle: en-tête (model_header_t), centroïdes
+ * (n_clusters x dims, en double) puis effectif de chaque cluster
+ * (uint64).
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ * \param filename nom du fichier
+ */
+void save_kmeans(kmeans_t * kmeans, config_t * cfg, char * filename) {
+  FILE * fp = fopen(filename, "wb");
+  model_header_t hdr;
+  double v;
+  uint64_t count;
+  int cl, j;
+
+  if(!fp) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    exit(1);
+  }
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, MODEL_MAGIC, sizeof(hdr.magic));
+  hdr.dims = cfg->nb_val;
+  hdr.n_clusters = kmeans->n_clusters;
+  hdr.inertia = kmeans->inertia;
+  fwrite(&hdr, sizeof(hdr), 1, fp);
+  for(cl = 0; cl < kmeans->n_clusters; cl++)
+    for(j = 0; j < cfg->nb_val; j++) {
+      v = CENTROID(kmeans, cl)[j];
+      fwrite(&v, sizeof(v), 1, fp);
+    }
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    count = kmeans->counts[cl];
+    fwrite(&count, sizeof(count), 1, fp);
+  }
+
+  if(ferror(fp) | fclose(fp)) {
+    fprintf(stderr, "Error while writing file %s\n", filename);
+    exit(1);
+  }
+}
+
+/** \brief Charge un modèle enregistré par save_kmeans. Le nombre de
+ * valeurs par donnée et le nombre de clusters de cfg sont remplacés
+ * par ceux du modèle.
+ *
+ * \param filename nom du fichier
+ * \param cfg données de configuration
+ *
+ * \return le modèle KMeans, sans données
+ */
+kmeans_t * load_kmeans(char * filename, config_t * cfg) {
+  FILE * fp = fopen(filename, "rb");
+  kmeans_t * kmeans = (kmeans_t *)calloc(1, sizeof(*kmeans));
+  model_header_t hdr;
+  double v;
+  uint64_t count;
+  int cl, j;
+  assert(kmeans);
+
+  if(!fp) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    exit(1);
+  }
+  if(fread(&hdr, sizeof(hdr), 1, fp) != 1 || memcmp(hdr.magic, MODEL_MAGIC, sizeof(hdr.magic)) ||
+      hdr.dims < 1 || hdr.n_clusters < 1 || hdr.dims > INT_MAX || hdr.n_clusters > INT_MAX) {
+    fprintf(stderr, "Unknown model format in %s\n", filename);
+    exit(1);
+  }
+
+  cfg->nb_val = hdr.dims;
+  cfg->n_clusters = hdr.n_clusters;
+  kmeans->n_clusters = hdr.n_clusters;
+  kmeans->stride = (cfg->nb_val + DATA_SIMD_WIDTH - 1) / DATA_SIMD_WIDTH * DATA_SIMD_WIDTH;
+  kmeans->inertia = hdr.inertia;
+  kmeans->eps = dist_eps(cfg);
+
+  if(posix_memalign((void **)&kmeans->centroids, DATA_ALIGN,
+      (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->centroids))) {
+    fprintf(stderr, "Can't allocate %d centroids\n", kmeans->n_clusters);
+    exit(1);
+  }
+  memset(kmeans->centroids, 0, (size_t)kmeans->n_clusters * kmeans->stride * sizeof(*kmeans->centroids));
+  kmeans->counts = (int *)malloc(kmeans->n_clusters * sizeof(*kmeans->counts));
+  assert(kmeans->counts);
+
+  for(cl = 0; cl < kmeans->n_clusters; cl++)
+    for(j = 0; j < cfg->nb_val; j++) {
+      if(fread(&v, sizeof(v), 1, fp) != 1) {
+        fprintf(stderr, "Error while reading file %s\n", filename);
+        exit(1);
+      }
+      CENTROID(kmeans, cl)[j] = v;
+    }
+  for(cl = 0; cl < kmeans->n_clusters; cl++) {
+    if(fread(&count, sizeof(count), 1, fp) != 1 || count > INT_MAX) {
+      fprintf(stderr, "Error while reading file %s\n", filename);
+      exit(1);
+    }
+    kmeans->counts[cl] = count;
+  }
+
+  fclose(fp);
+  return kmeans;
+}
+
+/** \brief Ramène un modèle appris sur les données distinctes
+ * (dedup_data) aux données d'origine: chaque donnée reçoit le cluster
+ * de sa ligne distincte. Les effectifs et l'inertie, pondérés, sont
+ * déjà ceux des données d'origine.
+ *
+ * \param kmeans modèle KMeans appris sur les données distinctes
+ * \param data données d'origine
+ * \param map indice de la ligne distincte de chaque donnée
+ */
+void expand_clusters(kmeans_t * kmeans, data_t * data, const int * map) {
+  int * cluster_id = (int *)malloc(data->n * sizeof(*cluster_id));
+  int i;
+  assert(cluster_id);
+
+  for(i = 0; i < data->n; i++)
+    cluster_id[i] = kmeans->cluster_id[map[i]];
+  free(kmeans->cluster_id);
+  kmeans->cluster_id = cluster_id;
+  kmeans->data = data;
+  kmeans->data_sz = data->n;
+}
+
+/** \brief Affiche les clusters de KMeans.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+void print_cluster(kmeans_t * kmeans, data_t * data, config_t * cfg) {
+  int i, d;
+  for(i = 0; i < kmeans->data_sz; i++) {
+    for(d = 0; d < cfg->nb_val; d++)
+      printf("%.1f,", DATA_ROW(data, i)[d]);
+    printf("cluster-%d (%s)\n", kmeans->cluster_id[i], data->labels->names[data->label[i]]);
+  }
+}
+
+/** \brief Libère le modèle KMeans.
+ *
+ * \param kmeans modèle KMeans
+ */
+void free_kmeans(kmeans_t * kmeans) {
+  int i;
   if(kmeans) {
+    free(kmeans->cluster_id);
+    free(kmeans->centroids);
+    free(kmeans->sums);
+    free(kmeans->counts);
+    free(kmeans->upper);
+    free(kmeans->lower);
+    free(kmeans->half_cc);
+    free(kmeans->half_min);
+    free(kmeans->delta);
+    free(kmeans->delta_f);
+    free(kmeans->prev);
+    free(kmeans->xnorm);
+    free(kmeans->ct);
+    free(kmeans->cnorm);
+    free(kmeans->cum_weight);
+    for(i = 0; i < kmeans->n_blocks; i++)
+      free(kmeans->blocks[i].sums);
+    free(kmeans->blocks);
     free(kmeans);
     kmeans = NULL;
   }
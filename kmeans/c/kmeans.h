@@ -7,26 +7,82 @@
 #define _KMEANS_H_
 
 #include "parser.h"
+#include "dist.h"
 #include "config.h"
 
-/* Structure représentant un point dans KMeans */
-typedef struct point point_t;
-struct point {
-  data_t data;    // donnée
-  int cluster_id; // identifiant du cluster
+/* Structure représentant un bloc de données affecté par un
+ * seul thread, avec ses sommes et effectifs partiels */
+typedef struct kblock kblock_t;
+struct kblock {
+  int from;      // indice de la première donnée du bloc
+  int to;        // indice qui suit la dernière donnée du bloc
+  int changed;   // nombre de changements de cluster dans le bloc
+  double * sums; // somme des données de chaque cluster dans le bloc
+  int * counts;  // nombre de données de chaque cluster dans le bloc
+  double inertia; // somme des distances au carré des données du bloc à leur centroïde
+};
+
+#define MODEL_MAGIC "KMMODEL1" // signature du fichier de modèle
+
+/** \brief En-tête du fichier de modèle (ordre des octets de la
+ * machine). Il est suivi des centroïdes (n_clusters x dims valeurs
+ * en double) puis de l'effectif de chaque cluster (uint64) */
+typedef struct model_header model_header_t;
+struct model_header {
+  char magic[8];       // signature MODEL_MAGIC
+  uint32_t dims;       // nombre de valeurs par donnée
+  uint32_t n_clusters; // nombre de clusters
+  double inertia;      // inertie du modèle sur ses données d'apprentissage (estimée après -w)
 };
 
 /* Structure représentant le modèle KMeans */
 typedef struct kmeans kmeans_t;
 struct kmeans {
-  point_t * points;    // les données à clusteriser
-  double ** centroids; // centroïdes
-  int data_sz;         // nombre de données
-  int n_clusters;      // nombre de clusters
+  data_t * data;         // les données à clusteriser
+  int * cluster_id;      // identifiant du cluster de chaque donnée
+  ml_real_t * centroids; // centroïdes (bloc n_clusters x stride aligné)
+  double * sums;         // somme des données de chaque cluster (n_clusters x stride)
+  int * counts;          // nombre de données de chaque cluster
+  int data_sz;           // nombre de données
+  int n_clusters;        // nombre de clusters
+  int stride;            // pas entre deux centroïdes
+  double inertia;        // somme des distances au carré des données à leur centroïde
+  double shift;          // déplacement des centroïdes à la dernière mise à jour (somme des carrés)
+  double tol;            // seuil absolu de déplacement (cfg->tol x variance moyenne)
+  double * upper;        // borne supérieure de la distance de chaque donnée à son centroïde (Elkan, Hamerly)
+  float * lower;         // bornes inférieures des distances aux autres centroïdes (n x k Elkan, n Hamerly)
+  double * half_cc;      // moitié des distances entre centroïdes (k x k, Elkan)
+  double * half_min;     // moitié de la distance de chaque centroïde au plus proche autre
+  double * delta;        // déplacement de chaque centroïde à la dernière mise à jour
+  float * delta_f;       // déplacements arrondis vers le haut en simple précision (Elkan)
+  double delta_max[2];   // deux plus grands déplacements (Hamerly)
+  int delta_arg;         // centroïde qui s'est le plus déplacé (Hamerly)
+  ml_real_t * prev;      // centroïdes avant la dernière mise à jour
+  double eps;            // marge relative des distances (erreurs d'arrondi)
+  double * xnorm;        // norme au carré de chaque donnée (GEMM)
+  double * ct;           // centroïdes transposés par panneaux de GEMM_NR colonnes (GEMM)
+  double * cnorm;        // norme au carré de chaque centroïde, k_pad (GEMM)
+  double cnorm_max;      // plus grande norme au carré des centroïdes (GEMM)
+  int k_pad;             // nombre de centroïdes arrondi à la micro-tuile (GEMM)
+  void (* gemm)(const ml_real_t *, int, int, const double *, int, int, double *); // produits scalaires d'une tuile (GEMM)
+  int bounded;           // bornes initialisées
+  kblock_t * blocks;     // blocs de données (découpage indépendant du nombre de threads)
+  int n_blocks;          // nombre de blocs
+  int n_threads;         // nombre de threads
+  double * cum_weight;   // poids cumulés des données (NULL: données non pondérées)
 };
 
+/** \brief Accède au centroïde c */
+#define CENTROID(kmeans, c) ((kmeans)->centroids + (size_t)(c) * (kmeans)->stride)
+
 kmeans_t * init_kmeans(data_t *, config_t *);
 void       cluster(kmeans_t *, data_t *, config_t *);
+kmeans_t * fit_kmeans(data_t *, config_t *);
+int *      predict(kmeans_t *, data_t *, config_t *);
+void       save_kmeans(kmeans_t *, config_t *, char *);
+kmeans_t * load_kmeans(char *, config_t *);
+int *      fold_in(kmeans_t *, data_t *, config_t *);
+void       expand_clusters(kmeans_t *, data_t *, const int *);
 void       print_cluster(kmeans_t *, data_t *, config_t *);
 void       free_kmeans(kmeans_t *);
 
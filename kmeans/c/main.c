@@ -7,36 +7,187 @@
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include "parser.h"
 #include "config.h"
 #include "kmeans.h"
 
+#define SERVE_ROWS 65536 // nombre de lignes par lot lu sur l'entrée standard
+
 void usage(char * exec) {
-  fprintf(stderr, "Usage: %s <file>.\n", exec);
+  fprintf(stderr, "Usage: %s [-o <model>] <file>.\n", exec);
+  fprintf(stderr, "       %s -m <model> [<file> ...].\n", exec);
+  fprintf(stderr, "       %s -w <model> [-o <model>] <file>.\n", exec);
   exit(1);
 }
 
+/** \brief Affiche l'identifiant du cluster de chaque donnée, une
+ * donnée par ligne.
+ *
+ * \param predicted identifiants des clusters
+ * \param n nombre de données
+ */
+static void print_predicted(int * predicted, int n) {
+  int i;
+  for(i = 0; i < n; i++)
+    printf("%d\n", predicted[i]);
+  fflush(stdout);
+}
+
+/** \brief Lit un fichier de données (CSV ou binaire) à affecter
+ * aux clusters d'un modèle. L'étiquette des lignes CSV est
+ * facultative; une ligne (ou un fichier binaire) dont le nombre de
+ * valeurs diffère de celui du modèle est rejetée.
+ *
+ * \param filename fichier de données
+ * \param cfg données de configuration (cfg->nb_val fixé par le modèle)
+ *
+ * \return les données
+ */
+static data_t * read_model_data(char * filename, config_t * cfg) {
+  data_t * data = load_values(filename, cfg->nb_val);
+  cfg->data_sz = data->n;
+  return data;
+}
+
+/** \brief Affecte les données d'un fichier (CSV ou binaire) aux
+ * clusters du modèle.
+ *
+ * \param kmeans modèle KMeans
+ * \param filename fichier de données
+ * \param cfg données de configuration
+ */
+static void assign_file(kmeans_t * kmeans, char * filename, config_t * cfg) {
+  data_t * data = read_model_data(filename, cfg);
+  int * predicted = predict(kmeans, data, cfg);
+  print_predicted(predicted, data->n);
+  free(predicted);
+  free_data(data);
+}
+
+/** \brief Affecte les lignes CSV lues sur l'entrée standard aux
+ * clusters du modèle, par lots de SERVE_ROWS lignes (ou moins à la
+ * fin de l'entrée); les affectations d'un lot sont écrites dès
+ * qu'il est traité.
+ *
+ * \param kmeans modèle KMeans
+ * \param cfg données de configuration
+ */
+static void assign_stdin(kmeans_t * kmeans, config_t * cfg) {
+  char * batch = NULL, * line = NULL;
+  size_t cap = 0, sz = 0, line_cap = 0;
+  ssize_t len;
+  int rows = 0, eof = 0;
+
+  while(!eof) {
+    len = getline(&line, &line_cap, stdin);
+    if(len < 0)
+      eof = 1;
+    else if(len > 1 || (len == 1 && line[0] != '\n')) {
+      if(sz + len + 1 > cap) {
+        cap = 2 * (sz + len + 1);
+        batch = (char *)realloc(batch, cap);
+        assert(batch);
+      }
+      memcpy(batch + sz, line, len);
+      sz += len;
+      if(line[len - 1] != '\n')
+        batch[sz++] = '\n';
+      rows++;
+    }
+
+    if(rows && (eof || rows == SERVE_ROWS)) {
+      data_t * data = parse_csv(batch, sz, "stdin", cfg->nb_val, CSV_LABEL_OPTIONAL);
+      int * predicted = predict(kmeans, data, cfg);
+      print_predicted(predicted, data->n);
+      free(predicted);
+      free_data(data);
+      rows = 0;
+      sz = 0;
+    }
+  }
+
+  free(line);
+  free(batch);
+}
+
 int main(int argc, char *argv[]) {
-  if(argc != 2)
+  char * model_out = NULL, * model_in = NULL, * model_warm = NULL;
+  int opt, i;
+
+  while((opt = getopt(argc, argv, "o:m:w:")) != -1) {
+    switch(opt) {
+      case 'o': model_out = optarg; break;
+      case 'm': model_in = optarg; break;
+      case 'w': model_warm = optarg; break;
+      default: usage(argv[0]);
+    }
+  }
+  if(model_in ? model_out != NULL || model_warm != NULL : optind != argc - 1)
     usage(argv[0]);
 
   config_t * cfg = init_config(CONFIG_FILE);
 
-  data_t * data = read_file(argv[1], cfg);
-  // normalize(data, cfg);
+  // affectation seule: modèle enregistré, fichiers ou entrée standard
+  if(model_in) {
+    kmeans_t * kmeans = load_kmeans(model_in, cfg);
+    if(optind == argc)
+      assign_stdin(kmeans, cfg);
+    for(i = optind; i < argc; i++)
+      assign_file(kmeans, argv[i], cfg);
+    free_kmeans(kmeans);
+    free_config(cfg);
+    return 0;
+  }
 
-  kmeans_t * kmeans = init_kmeans(data, cfg);
-  cluster(kmeans, data, cfg);
-  print_cluster(kmeans, data, cfg);
+  // démarrage à chaud: ajout de nouvelles données au modèle enregistré
+  if(model_warm) {
+    kmeans_t * kmeans = load_kmeans(model_warm, cfg);
+    data_t * data = read_model_data(argv[optind], cfg);
+    int * predicted = fold_in(kmeans, data, cfg);
+    print_predicted(predicted, data->n);
+    if(model_out)
+      save_kmeans(kmeans, cfg, model_out);
+    free(predicted);
+    free_data(data);
+    free_kmeans(kmeans);
+    free_config(cfg);
+    return 0;
+  }
 
-  free_config(cfg);
-  free_data(data);
-  free_kmeans(kmeans);
+  data_t * data = read_file(argv[optind], cfg), * uniq = NULL;
+  int * map = NULL;
+  // normalize(data);
+
+  // données identiques regroupées: clustering pondéré des lignes distinctes
+  if(cfg->dedup) {
+    map = (int *)malloc(data->n * sizeof(*map));
+    assert(map);
+    uniq = dedup_data(data, map);
+    cfg->data_sz = uniq->n;
+    if(cfg->verbose)
+      fprintf(stderr, "dedup: %d data, %d distinct\n", data->n, uniq->n);
+  }
+
+  kmeans_t * kmeans = fit_kmeans(uniq ? uniq : data, cfg);
+  if(uniq)
+    expand_clusters(kmeans, data, map);
+  print_cluster(kmeans, data, cfg);
+  printf("inertia: %g\n", kmeans->inertia);
+  if(model_out)
+    save_kmeans(kmeans, cfg, model_out);
 
 #ifdef DEBUG
   print_config(cfg);
-  print_data(data, cfg);
+  print_data(data);
 #endif
 
+  free_config(cfg);
+  free_data(data);
+  free_data(uniq);
+  free(map);
+  free_kmeans(kmeans);
+
   return 0;
-}
\ No newline at end of file
+}
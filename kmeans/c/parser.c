@@ -1,21 +1,20 @@
 /*!
  * \file parser.c
  * \brief Fichier comprenant les fonctionnalités
- * de parsing pour parser les données en entrée et
- * le fichier config
+ * de parsing pour parser le fichier config; les
+ * données en entrée sont chargées par libml
  * \author PANCHALINGAMOORTHY Gajenthran
  */
 #include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
-#include <time.h>
 #include "parser.h"
 
-/** \brief Lire le fichiers de données, tokenizer son
- * contenu où chaque valeur est séparée par une virgule
- * placer les éléments dans la struct data_t.
+/** \brief Lire le fichier de données (CSV ou binaire) grâce à
+ * libml et renseigner la taille des données, le nombre de valeurs
+ * par donnée (déduit du fichier si absent de la configuration) et le nombre
+ * d'étiquettes dans la configuration.
  *
  * \param filename nom du fichier
  * \param cfg données de configuration
@@ -24,66 +23,13 @@
  * les données formalisées
  */
 data_t * read_file(char * filename, config_t * cfg) {
-  const int MAX = 1024;
-  FILE * fp = fopen(filename, "r");
-  if(!fp) {
-    fprintf(stderr, "Can't open file %s\n", filename);
-    exit(1);
-  }
-
-  int line = 0, j = 0;
-  char * buf = (char *)malloc(MAX * sizeof(*buf)), * tok, * end;
-  assert(buf);
-  data_t * data = (data_t *)malloc(MAX * sizeof(*data));
-  assert(data);
-
-  while(!feof(fp)) {
-    fgets(buf, MAX, fp);
-    if(ferror(fp)) {
-      fprintf( stderr, "Error while reading file %s\n", filename);
-      exit(1);
-    }
-
-    // tokenizer la ligne récupérée par fgets
-    char * label;
-    tok = strtok(buf, ",");
-    data[line].v = (double *)malloc(cfg->nb_val * sizeof(*data[line].v));
-    assert(data[line].v);
-
-    j = 0;
-    while(tok != NULL) {
-      if(j < cfg->nb_val)
-        data[line].v[j++] = strtod(tok, &end);
-      label = tok;
-      tok = strtok(NULL, ",");
-    }
-    label = strtok(label, "\n");
-    data[line++].label = strdup(label);
-  }
-
-  cfg->data_sz = line;
+  data_t * data = load_data(filename, cfg->nb_val);
+  cfg->nb_val = data->d;
+  cfg->data_sz = data->n;
+  cfg->nb_label = data->labels->size;
   return data;
 }
 
-/** \brief Normalise les données.
- *
- * \param data ensemble de données
- * \param cfg  données de configuration
- */
-void normalize(data_t * data, config_t * cfg) {
-  int i, j;
-  double sum;
-
-  for(i = 0; i < cfg->data_sz; i++) {
-    sum = 0;
-    for(j = 0; j < cfg->nb_val; j++)
-      sum += pow(data[i].v[j], 2.0);
-    data[i].norm = sqrt(sum);
-    for(j = 0; j < cfg->nb_val; j++)
-      data[i].v[j] /= data[i].norm;
-  }
-}
-
 /** \brief Initialise les données de
  * configuration
  *
@@ -101,7 +47,7 @@ config_t * init_config(char * filename) {
 
   char * buf = (char *)malloc(MAX * sizeof(*buf)), * tok; /* * end; */
   assert(buf);
-  config_t * cfg = (config_t *)malloc(sizeof *cfg);
+  config_t * cfg = (config_t *)calloc(1, sizeof *cfg);
   assert(cfg);
 
   while(!feof(fp)) {
@@ -130,6 +76,69 @@ config_t * init_config(char * filename) {
         } else if(!strcmp(tok, "N_ITERS")) {
           tok = strtok(NULL, "=");
           cfg->n_iters = atoi(tok);
+        } else if(!strcmp(tok, "SEED")) {
+          tok = strtok(NULL, "=");
+          cfg->seed = strtoull(tok, NULL, 10);
+        } else if(!strcmp(tok, "N_THREADS")) {
+          tok = strtok(NULL, "=");
+          cfg->n_threads = atoi(tok);
+        } else if(!strcmp(tok, "N_INIT")) {
+          tok = strtok(NULL, "=");
+          cfg->n_init = atoi(tok);
+        } else if(!strcmp(tok, "TOL")) {
+          tok = strtok(NULL, "=");
+          cfg->tol = atof(tok);
+        } else if(!strcmp(tok, "VERBOSE")) {
+          tok = strtok(NULL, "=");
+          cfg->verbose = atoi(tok);
+        } else if(!strcmp(tok, "DEDUP")) {
+          tok = strtok(NULL, "=");
+          cfg->dedup = atoi(tok);
+        } else if(!strcmp(tok, "WARM_ITERS")) {
+          tok = strtok(NULL, "=");
+          cfg->warm_iters = atoi(tok);
+        } else if(!strcmp(tok, "BATCH_SIZE")) {
+          tok = strtok(NULL, "=");
+          cfg->batch_sz = atoi(tok);
+        } else if(!strcmp(tok, "BATCH_TOL")) {
+          tok = strtok(NULL, "=");
+          cfg->batch_tol = atof(tok);
+        } else if(!strcmp(tok, "ALGORITHM")) {
+          tok = strtok(NULL, "=\r\n");
+          if(tok && !strcmp(tok, "lloyd"))
+            cfg->algo = ALGO_LLOYD;
+          else if(tok && !strcmp(tok, "elkan"))
+            cfg->algo = ALGO_ELKAN;
+          else if(tok && !strcmp(tok, "hamerly"))
+            cfg->algo = ALGO_HAMERLY;
+          else if(tok && !strcmp(tok, "gemm"))
+            cfg->algo = ALGO_GEMM;
+          else {
+            fprintf(stderr, "Unknown ALGORITHM value in %s\n", filename);
+            exit(1);
+          }
+        } else if(!strcmp(tok, "INIT")) {
+          tok = strtok(NULL, "=\r\n");
+          if(tok && !strcmp(tok, "kmeans++"))
+            cfg->init = INIT_KMEANSPP;
+          else if(tok && !strcmp(tok, "kmeans||"))
+            cfg->init = INIT_KMEANS_PAR;
+          else if(tok && !strcmp(tok, "random"))
+            cfg->init = INIT_RANDOM;
+          else {
+            fprintf(stderr, "Unknown INIT value in %s\n", filename);
+            exit(1);
+          }
+        } else if(!strcmp(tok, "EMPTY_CLUSTER")) {
+          tok = strtok(NULL, "=\r\n");
+          if(tok && !strcmp(tok, "farthest"))
+            cfg->empty = EMPTY_FARTHEST;
+          else if(tok && !strcmp(tok, "keep"))
+            cfg->empty = EMPTY_KEEP;
+          else {
+            fprintf(stderr, "Unknown EMPTY_CLUSTER value in %s\n", filename);
+            exit(1);
+          }
         } else {
           fprintf( stderr, "Error while reading file %s\n", filename);
           exit(1);
@@ -138,6 +147,7 @@ config_t * init_config(char * filename) {
       tok = strtok(NULL, "=");
     }
   }
+  init_rng(cfg->seed);
   return cfg;
 }
 
@@ -152,33 +162,24 @@ void free_config(config_t * cfg) {
   }
 }
 
-/** \brief Libère les données de la bd.
- *
- * \param data ensemble de données
- */
-void free_data(data_t * data) {
-  if(data) {
-    free(data);
-    data = NULL;
-  }
-}
-
 #ifdef DEBUG
-void print_data(data_t * data, config_t * cfg) {
-  int i, j;
-  for(i = 0; i < cfg->data_sz; i++) {
-    for(j = 0; j < cfg->nb_val; j++) {
-      printf("%.1f,", data[i].v[j]);
-    }
-    printf("%s\n", data[i].label);
-  }
-}
-
 void print_config(config_t * cfg) {
   printf("nb_val:   %d\n", cfg->nb_val);
   printf("data_sz:  %d\n", cfg->data_sz);
   printf("n_label:  %d\n", cfg->nb_label);
   printf("n_iters:  %d\n", cfg->n_iters);
   printf("clusters: %d\n", cfg->n_clusters);
+  printf("algo:     %s\n", cfg->algo == ALGO_ELKAN ? "elkan" :
+    cfg->algo == ALGO_HAMERLY ? "hamerly" : cfg->algo == ALGO_GEMM ? "gemm" : "lloyd");
+  printf("init:     %s\n", cfg->init == INIT_RANDOM ? "random" :
+    cfg->init == INIT_KMEANS_PAR ? "kmeans||" : "kmeans++");
+  printf("empty:    %s\n", cfg->empty == EMPTY_KEEP ? "keep" : "farthest");
+  printf("threads:  %d\n", cfg->n_threads);
+  printf("n_init:   %d\n", cfg->n_init);
+  printf("tol:      %g\n", cfg->tol);
+  printf("verbose:  %d\n", cfg->verbose);
+  printf("warm:     %d\n", cfg->warm_iters);
+  printf("dedup:    %d\n", cfg->dedup);
+  printf("batch:    %d (tol %g)\n", cfg->batch_sz, cfg->batch_tol);
 }
 #endif
\ No newline at end of file
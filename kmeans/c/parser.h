@@ -6,26 +6,16 @@
 #ifndef _PARSER_H_
 #define _PARSER_H_
 
+#include "data.h"
+#include "rng.h"
 #include "config.h"
 
-/** \brief Structure représentant les données */
-typedef struct data data_t;
-struct data {
-  double * v;   // vecteur de données
-  int index;    // index dans la bdd
-  char * label; // étiquette
-  double norm;  // norme
-};
-
 data_t *   read_file(char *, config_t *);
-void       normalize(data_t *, config_t *);
 config_t * init_config(char *);
 void       free_config(config_t *);
-void       free_data(data_t *);
 
 #ifdef DEBUG
-void       print_data(data_t *, config_t *);
 void       print_config(config_t *);
 #endif
 
-#endif
\ No newline at end of file
+#endif
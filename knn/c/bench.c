@@ -0,0 +1,60 @@
+/*!
+ * \file bench.c
+ * \brief Fichier principale concernant la mesure des
+ * performances de kNN: chargement, initialisation (découpage
+ * des données) et prédiction, répétés dans le même processus.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "parser.h"
+#include "knn.h"
+#include "config.h"
+
+int main(int argc, char *argv[]) {
+  int reps, r;
+  char * json = NULL;
+  char * filename = bench_args(argc, argv, &reps, &json);
+
+  config_t * cfg = init_config(CONFIG_FILE);
+  bench_t * b = init_bench("knn", filename, reps);
+
+  for(r = 0; r < reps; r++) {
+    // mêmes tirages aléatoires à chaque répétition
+    init_rng(cfg->seed);
+
+    bench_start(b);
+    data_t * data = read_file(filename, cfg);
+    bench_stop(b, "load", data->n);
+
+    bench_start(b);
+    int * sh = init_shuffle(cfg->data_sz);
+    data_t * test = test_split(data, sh, cfg);
+    data_t * train = train_split(data, sh, cfg);
+    knn_t * knn = init_knn(train, cfg);
+    bench_stop(b, "init", data->n);
+
+    bench_start(b);
+    int * predicted = predict(knn, test, cfg);
+    bench_stop(b, "predict", test->n);
+
+    b->rows = data->n;
+    b->dims = data->d;
+    free(predicted);
+    free_knn(knn);
+    free_data(train);
+    free_data(test);
+    free_data(data);
+    free_shuffle(sh);
+  }
+
+  print_bench(b);
+  if(json)
+    write_bench_json(b, json);
+
+  free_bench(b);
+  free_config(cfg);
+  return 0;
+}
@@ -18,6 +18,7 @@ struct config {
   int nb_label;   // nombre de labels
   int nb_neighbors;
   float test_size;  // proportion des données pour le test
+  unsigned long long seed; // graine des tirages aléatoires (0: aléatoire)
 };
 
 #endif
\ No newline at end of file
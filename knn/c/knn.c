@@ -13,101 +13,63 @@
 #include <math.h>
 #include "knn.h"
 
-/** \brief Calcule la distance euclidienne de deux vecteurs.
- *
- * \param v vecteur v
- * \param w vecteur w
- * \param size taille des vecteurs v et w (partageant la même taille)
- *
- * \return la distance de l'ensemble des deux vecteurs.
- */
-static double euclidean_dist(double * v, double * w, int size) {
-  double sum = 0;
-  int i;
-  for(i = 0; i < size; i++)
-    sum += pow(v[i] - w[i], 2.0);
-  return sqrt(sum);
-}
-
 /** \brief Trouve les k voisins en calculant la distance euclidienne
- * entre le point choisi et les autres données.
+ * entre le point choisi et les autres données. Les voisins sont
+ * maintenus triés par distance au carré croissante; la racine
+ * n'est calculée que pour l'état d'activation des k voisins retenus.
  *
  * \param knn structure knn
- * \param test_row donnée à classifier
- * \param distances les distances entre la donnée et les autres
- * \param index_distances les indices des distances entre la donnée et les autres
+ * \param test_row vecteur de la donnée à classifier
+ * \param distances les distances (au carré) entre la donnée et les voisins
+ * \param index_distances les indices des voisins dans les données d'apprentissage
  */
 static void find_neighbors(
-  knn_t * knn, data_t test_row, double * distances, int * index_distances, config_t * cfg) {
-  int tmp_i, tmp_dist, tr, nbn, 
-      train_size = cfg->data_sz - (int)(cfg->data_sz * cfg->test_size);
+  knn_t * knn, const ml_real_t * test_row, double * distances, int * index_distances, config_t * cfg) {
+  PROF_BEGIN(find, "find_neighbors");
+  int tr, nbn, train_size = knn->train->n;
   double dist;
 
-  for(nbn = 0; nbn < knn->nb_neighbors; nbn++) {
-  index_distances[nbn] = nbn;
-  distances[nbn] = euclidean_dist(
-      knn->train[nbn].v, test_row.v, cfg->nb_val);
-  }
-
   // find k nearest neigbors
-  for(tr = 1; tr < train_size; tr++) {
-    nbn = 0;
-    dist = euclidean_dist(
-      knn->train[tr].v, test_row.v, cfg->nb_val);
-    while(nbn < cfg->nb_neighbors) {
-      if(dist < distances[nbn]) {
-        tmp_i = index_distances[nbn];
-        tmp_dist = distances[nbn];
-        distances[nbn] = dist;
-        index_distances[nbn] = tr;
-        nbn++;
-        while(nbn < cfg->nb_neighbors) {
-          tmp_i = index_distances[nbn];
-          tmp_dist = distances[nbn];
-          distances[nbn] = tmp_dist;
-          index_distances[nbn] = tmp_i;
-          nbn++;
-        }
-        break;
-      }
-      nbn++;
+  for(tr = 0; tr < train_size; tr++) {
+    dist = sq_l2_dist(DATA_ROW(knn->train, tr), test_row, cfg->nb_val);
+    if(dist >= distances[knn->nb_neighbors - 1])
+      continue;
+
+    for(nbn = knn->nb_neighbors - 1; nbn > 0 && distances[nbn - 1] > dist; nbn--) {
+      distances[nbn] = distances[nbn - 1];
+      index_distances[nbn] = index_distances[nbn - 1];
     }
+    distances[nbn] = dist;
+    index_distances[nbn] = tr;
   }
 
   // assign neighbors
   for(nbn = 0; nbn < knn->nb_neighbors; nbn++) {
-    knn->neighbors[nbn].act = distances[nbn];
+    knn->neighbors[nbn].act = sqrt(distances[nbn]);
     knn->neighbors[nbn].index = index_distances[nbn];
-    knn->neighbors[nbn].label = strdup(knn->train[index_distances[nbn]].label);
+    knn->neighbors[nbn].label = knn->train->label[index_distances[nbn]];
   }
+  PROF_END(find);
 }
 
-/** \brief Labelise les données tests.
+/** \brief Labelise les données tests par vote des voisins.
  *
  * \param knn structure knn
  * \param cfg données de configuration
+ *
+ * \return l'identifiant de l'étiquette majoritaire
  */
-static const char * label(knn_t * knn, config_t * cfg) {
-  int nb_label = cfg->nb_label, l, lab, nbn, * indexes;
-
-  const char * labels[] = {
-    "Iris-setosa",
-    "Iris-versicolor",
-    "Iris-virginica"
-  };
-
-  indexes = (int *)calloc(0, knn->nb_neighbors * sizeof(*indexes));
-  assert(indexes);
+static int label(knn_t * knn, config_t * cfg) {
+  int l, lab = 0, nbn;
 
+  memset(knn->votes, 0, cfg->nb_label * sizeof(*knn->votes));
   for(nbn = 0; nbn < knn->nb_neighbors; nbn++)
-    for(l = 0; l < nb_label; l++)
-      if(!strcmp(labels[l], knn->neighbors[nbn].label))
-        indexes[l]++;
+    knn->votes[knn->neighbors[nbn].label]++;
 
-  for(l = 1; l < nb_label; l++)
-    if(indexes[l] > indexes[lab])
+  for(l = 1; l < cfg->nb_label; l++)
+    if(knn->votes[l] > knn->votes[lab])
       lab = l;
-  return labels[lab];
+  return lab;
 }
 
 /** \brief Initialise les distances pour lancer le kNN.
@@ -118,23 +80,32 @@ static const char * label(knn_t * knn, config_t * cfg) {
  */
 static void init_distances(double * distances, int * indexes, int size) {
   int i;
-  for(i = 0; i < size; i++) { distances[i] = 1.0; indexes[i] = -1; }
+  for(i = 0; i < size; i++) { distances[i] = HUGE_VAL; indexes[i] = -1; }
 }
 
 
-/** \brief Initialise le kNN.
+/** \brief Initialise le kNN. Le nombre de voisins doit être compris
+ * entre 1 et le nombre de données d'apprentissage.
  *
+ * \param train données d'apprentissage
  * \param cfg données de configuration
  */
-knn_t * init_knn(config_t * cfg) {
+knn_t * init_knn(data_t * train, config_t * cfg) {
   knn_t * knn = (knn_t *)malloc(sizeof(*knn));
   assert(knn);
 
+  if(cfg->nb_neighbors < 1 || cfg->nb_neighbors > train->n) {
+    fprintf(stderr, "Can't find %d neighbors among %d training data\n", cfg->nb_neighbors, train->n);
+    exit(1);
+  }
+
   knn->nb_neighbors = cfg->nb_neighbors;
   knn->neighbors = (neighbors_t *)malloc(
     cfg->nb_neighbors * sizeof(*knn->neighbors));
   assert(knn->neighbors);
-  knn->train = NULL;
+  knn->votes = (int *)malloc(cfg->nb_label * sizeof(*knn->votes));
+  assert(knn->votes);
+  knn->train = train;
 
   return knn;
 }
@@ -144,9 +115,15 @@ knn_t * init_knn(config_t * cfg) {
  * \param knn structure knn
  * \param test données tests
  * \param cfg données de configuration
+ *
+ * \return l'identifiant de l'étiquette prédite pour chaque donnée test
  */
-data_t * predict(knn_t * knn, data_t * test, config_t * cfg) {
-  int i, test_size = (int)(cfg->data_sz * cfg->test_size);
+int * predict(knn_t * knn, data_t * test, config_t * cfg) {
+  PROF_BEGIN(predict, "predict");
+  int i, test_size = test->n;
+
+  int * predicted = (int *)malloc(test_size * sizeof(*predicted));
+  assert(predicted);
 
   int * index_distances = (int *)malloc(
     cfg->nb_neighbors * sizeof(*index_distances));
@@ -158,37 +135,29 @@ data_t * predict(knn_t * knn, data_t * test, config_t * cfg) {
 
   for(i = 0; i < test_size; i++) {
     init_distances(distances, index_distances, cfg->nb_neighbors);
-    find_neighbors(knn, test[i], distances, index_distances, cfg);
-    test[i].label = strdup(label(knn, cfg));
+    find_neighbors(knn, DATA_ROW(test, i), distances, index_distances, cfg);
+    predicted[i] = label(knn, cfg);
   }
 
   free(distances);
   free(index_distances);
 
-  return test;
+  PROF_END(predict);
+  return predicted;
 }
 
 /** \brief Évalue le score de la prédiction.
  *
- * \param data ensemble des données
  * \param test données tests
+ * \param predicted étiquettes prédites
  * \param cfg données de configuration
  */
-double predict_score(data_t * data, data_t * test, config_t * cfg) {
-  int i, ds, test_size = (int)(cfg->data_sz * cfg->test_size);
+double predict_score(data_t * test, int * predicted, config_t * cfg) {
+  int i, test_size = test->n;
   double rate = 0.0;
 
   for(i = 0; i < test_size; i++)
-    for(ds = 0; ds < cfg->data_sz; ds++)
-      if(
-        test[i].v[0] == data[ds].v[0] &&
-        test[i].v[1] == data[ds].v[1] &&
-        test[i].v[2] == data[ds].v[2] &&
-        test[i].v[3] == data[ds].v[3]
-      ) {
-        rate += (!strcmp(test[i].label, data[ds].label)) ? 1.0 : 0;
-        break;
-      }
+    rate += (predicted[i] == test->label[i]) ? 1.0 : 0;
 
   return rate / test_size;
 }
@@ -199,6 +168,8 @@ double predict_score(data_t * data, data_t * test, config_t * cfg) {
  */
 void free_knn(knn_t * knn) {
   if(knn) {
+    free(knn->neighbors);
+    free(knn->votes);
     free(knn);
     knn = NULL;
   }
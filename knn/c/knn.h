@@ -7,14 +7,15 @@
 #define _KNN_H_
 
 #include "parser.h"
+#include "dist.h"
 #include "config.h"
 
 /** \brief Structure représentant les voisins pour le kNN */
 typedef struct neighbors neighbors_t;
 struct neighbors {
-  int index;    // index dans la bdd
-  float act;    // état d'activation (distance)
-  char * label; // label
+  int index; // index dans la bdd
+  float act; // état d'activation (distance)
+  int label; // identifiant du label
 };
 
 /** \brief Structure représentant le modèle kNN */
@@ -22,12 +23,13 @@ typedef struct knn knn_t;
 struct knn {
   data_t * train;          // données d'apprentissage
   neighbors_t * neighbors; // voisins du kNN
+  int * votes;             // votes des voisins pour chaque label
   int nb_neighbors;        // nombre de voisins
 };
 
-knn_t *  init_knn(config_t *);
-data_t * predict(knn_t *, data_t *, config_t *);
-double   predict_score(data_t *, data_t *, config_t *);
+knn_t *  init_knn(data_t *, config_t *);
+int *    predict(knn_t *, data_t *, config_t *);
+double   predict_score(data_t *, int *, config_t *);
 void     free_knn(knn_t *);
 
 #endif
\ No newline at end of file
@@ -24,30 +24,33 @@ int main(int argc, char *argv[]) {
 
   data_t * data = NULL, 
          * test = NULL,
-         * train = NULL,
-         * predicted = NULL;
+         * train = NULL;
+  int * predicted = NULL;
 
   data = read_file(argv[1], cfg);
-  // normalize(data, cfg);
+  // normalize(data);
 
   const int * sh = init_shuffle(cfg->data_sz);
   test = test_split(data, sh, cfg);
   train = train_split(data, sh, cfg);
 
   knn_t * knn = NULL;
-  knn = init_knn(cfg);
-  knn->train = train_split(data, sh, cfg);
+  knn = init_knn(train, cfg);
   predicted = predict(knn, test, cfg);
-  printf("predict score: %.2f\n", predict_score(data, predicted, cfg));
-
-  free_config(cfg);
-  free_data(data, train, test);
-  free_knn(knn);
+  printf("predict score: %.2f\n", predict_score(test, predicted, cfg));
 
 #ifdef DEBUG
   print_config(cfg);
-  print_data(data, cfg);
+  print_data(data);
 #endif
 
+  free_config(cfg);
+  free_data(data);
+  free_data(train);
+  free_data(test);
+  free_knn(knn);
+  free(predicted);
+  free_shuffle((int *)sh);
+
   return 0;
 }
\ No newline at end of file
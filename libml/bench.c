@@ -0,0 +1,235 @@
+/*!
+ * \file bench.c
+ * \brief Fichier comprenant les fonctionnalités de mesure
+ * des performances des programmes (make bench): durée de chaque
+ * phase sur plusieurs répétitions, statistiques (min, médiane,
+ * p95, débit) et écriture d'un rapport JSON.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "bench.h"
+#include "data.h"
+#include "dist.h"
+
+/** \brief Statistiques des mesures d'une phase */
+typedef struct bench_stats bench_stats_t;
+struct bench_stats {
+  double min;    // durée minimale (s)
+  double median; // durée médiane (s)
+  double p95;    // 95e centile des durées (s)
+  double rate;   // débit pour la durée médiane (données/s)
+};
+
+/** \brief Renvoie l'horloge monotone en secondes */
+static double now(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+static int cmp_double(const void * a, const void * b) {
+  double x = *(const double *)a, y = *(const double *)b;
+  return (x > y) - (x < y);
+}
+
+/** \brief Calcule les statistiques des mesures d'une phase
+ * (le p95 est le centile de rang le plus proche).
+ *
+ * \param ph phase
+ *
+ * \return les statistiques de la phase
+ */
+static bench_stats_t phase_stats(const bench_phase_t * ph) {
+  bench_stats_t st = { 0, 0, 0, 0 };
+  double * t = (double *)malloc(ph->n * sizeof(*t));
+  assert(t);
+
+  memcpy(t, ph->t, ph->n * sizeof(*t));
+  qsort(t, ph->n, sizeof(*t), cmp_double);
+
+  st.min = t[0];
+  st.median = ph->n % 2 ? t[ph->n / 2] : (t[ph->n / 2 - 1] + t[ph->n / 2]) / 2;
+  st.p95 = t[(int)ceil(0.95 * ph->n) - 1];
+  st.rate = st.median > 0 ? ph->samples / st.median : 0;
+
+  free(t);
+  return st;
+}
+
+/** \brief Écrit une chaîne JSON (entre guillemets, échappée).
+ *
+ * \param fp fichier
+ * \param s chaîne
+ */
+static void json_str(FILE * fp, const char * s) {
+  fputc('"', fp);
+  for(; *s; s++) {
+    if(*s == '"' || *s == '\\') fputc('\\', fp);
+    if((unsigned char)*s >= 0x20) fputc(*s, fp);
+  }
+  fputc('"', fp);
+}
+
+static void usage_bench(char * exec) {
+  fprintf(stderr, "Usage: %s [-r reps] [-o <file>.json] <file>\n", exec);
+  exit(1);
+}
+
+/** \brief Lit les arguments d'un programme de benchmark.
+ *
+ * \param argc nombre d'arguments
+ * \param argv arguments
+ * \param reps nombre de répétitions (5 par défaut)
+ * \param json fichier du rapport JSON (NULL par défaut)
+ *
+ * \return le fichier de données
+ */
+char * bench_args(int argc, char ** argv, int * reps, char ** json) {
+  int opt;
+
+  *reps = 5;
+  *json = NULL;
+  while((opt = getopt(argc, argv, "r:o:")) != -1) {
+    switch(opt) {
+      case 'r': *reps = atoi(optarg); break;
+      case 'o': *json = optarg; break;
+      default: usage_bench(argv[0]);
+    }
+  }
+  if(optind != argc - 1 || *reps < 1)
+    usage_bench(argv[0]);
+
+  return argv[optind];
+}
+
+/** \brief Initialise un benchmark.
+ *
+ * \param prog nom du programme mesuré
+ * \param dataset fichier de données
+ * \param reps nombre de répétitions
+ */
+bench_t * init_bench(const char * prog, const char * dataset, int reps) {
+  bench_t * b = (bench_t *)calloc(1, sizeof(*b));
+  assert(b);
+
+  b->prog = prog;
+  b->dataset = dataset;
+  b->reps = reps;
+  return b;
+}
+
+/** \brief Démarre la mesure d'une phase.
+ *
+ * \param b benchmark
+ */
+void bench_start(bench_t * b) {
+  b->t0 = now();
+}
+
+/** \brief Termine la mesure d'une phase démarrée par
+ * bench_start, et l'ajoute aux mesures de cette phase.
+ *
+ * \param b benchmark
+ * \param name nom de la phase
+ * \param samples nombre de données traitées par la phase
+ */
+void bench_stop(bench_t * b, const char * name, long samples) {
+  double t = now() - b->t0;
+  bench_phase_t * ph = NULL;
+  int i;
+
+  for(i = 0; i < b->nb_phases && !ph; i++)
+    if(!strcmp(b->phases[i].name, name))
+      ph = &b->phases[i];
+
+  if(!ph) {
+    assert(b->nb_phases < BENCH_MAX_PHASES);
+    ph = &b->phases[b->nb_phases++];
+    ph->name = name;
+    ph->t = (double *)malloc(b->reps * sizeof(*ph->t));
+    assert(ph->t);
+  }
+  assert(ph->n < b->reps);
+  ph->samples = samples;
+  ph->t[ph->n++] = t;
+}
+
+/** \brief Affiche les statistiques de chaque phase.
+ *
+ * \param b benchmark
+ */
+void print_bench(bench_t * b) {
+  bench_stats_t st;
+  int i;
+
+  printf("%s: %s (%d x %d), %s, %s, %d reps\n", b->prog, b->dataset, b->rows, b->dims,
+    sizeof(ml_real_t) == sizeof(float) ? "float" : "double", ml_dist.name, b->reps);
+  printf("%-10s %12s %12s %12s %14s\n", "phase", "min (ms)", "median (ms)", "p95 (ms)", "samples/s");
+  for(i = 0; i < b->nb_phases; i++) {
+    st = phase_stats(&b->phases[i]);
+    printf("%-10s %12.3f %12.3f %12.3f %14.0f\n", b->phases[i].name,
+      st.min * 1e3, st.median * 1e3, st.p95 * 1e3, st.rate);
+  }
+}
+
+/** \brief Écrit le rapport JSON du benchmark: paramètres de
+ * la mesure, puis statistiques et durées de chaque phase (s).
+ *
+ * \param b benchmark
+ * \param filename nom du fichier
+ */
+void write_bench_json(bench_t * b, const char * filename) {
+  FILE * fp = fopen(filename, "w");
+  if(!fp) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    exit(1);
+  }
+
+  bench_stats_t st;
+  int i, j;
+
+  fprintf(fp, "{\n  \"program\": ");
+  json_str(fp, b->prog);
+  fprintf(fp, ",\n  \"dataset\": ");
+  json_str(fp, b->dataset);
+  fprintf(fp, ",\n  \"rows\": %d,\n  \"dims\": %d,\n", b->rows, b->dims);
+  fprintf(fp, "  \"precision\": \"%s\",\n  \"isa\": \"%s\",\n  \"reps\": %d,\n",
+    sizeof(ml_real_t) == sizeof(float) ? "float" : "double", ml_dist.name, b->reps);
+  fprintf(fp, "  \"phases\": [");
+  for(i = 0; i < b->nb_phases; i++) {
+    st = phase_stats(&b->phases[i]);
+    fprintf(fp, "%s\n    {\"name\": ", i ? "," : "");
+    json_str(fp, b->phases[i].name);
+    fprintf(fp, ", \"samples\": %ld, \"min\": %.9f, \"median\": %.9f, \"p95\": %.9f, "
+      "\"samples_per_s\": %.1f, \"times\": [", b->phases[i].samples,
+      st.min, st.median, st.p95, st.rate);
+    for(j = 0; j < b->phases[i].n; j++)
+      fprintf(fp, "%s%.9f", j ? ", " : "", b->phases[i].t[j]);
+    fprintf(fp, "]}");
+  }
+  fprintf(fp, "\n  ]\n}\n");
+
+  if(ferror(fp) | fclose(fp)) {
+    fprintf(stderr, "Error while writing file %s\n", filename);
+    exit(1);
+  }
+}
+
+/** \brief Libère le benchmark.
+ *
+ * \param b benchmark
+ */
+void free_bench(bench_t * b) {
+  if(b) {
+    int i;
+    for(i = 0; i < b->nb_phases; i++)
+      free(b->phases[i].t);
+    free(b);
+  }
+}
@@ -0,0 +1,43 @@
+/*!
+ * \file bench.h
+ * \brief Fichier header du fichier bench.c
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#ifndef _BENCH_H_
+#define _BENCH_H_
+
+#define BENCH_MAX_PHASES 8 // nombre maximal de phases mesurées
+
+/** \brief Structure représentant les mesures d'une phase
+ * (chargement, initialisation, apprentissage, prédiction) */
+typedef struct bench_phase bench_phase_t;
+struct bench_phase {
+  const char * name; // nom de la phase
+  long samples;      // nombre de données traitées par la phase
+  int n;             // nombre de mesures
+  double * t;        // durée de chaque mesure (s)
+};
+
+/** \brief Structure représentant un benchmark: une mesure
+ * de chaque phase par répétition */
+typedef struct bench bench_t;
+struct bench {
+  const char * prog;                      // programme mesuré
+  const char * dataset;                   // fichier de données
+  int reps;                               // nombre de répétitions
+  int rows;                               // nombre de données
+  int dims;                               // nombre de valeurs par donnée
+  int nb_phases;                          // nombre de phases
+  bench_phase_t phases[BENCH_MAX_PHASES]; // phases, dans l'ordre d'exécution
+  double t0;                              // début de la phase en cours (s)
+};
+
+char *    bench_args(int, char **, int *, char **);
+bench_t * init_bench(const char *, const char *, int);
+void      bench_start(bench_t *);
+void      bench_stop(bench_t *, const char *, long);
+void      print_bench(bench_t *);
+void      write_bench_json(bench_t *, const char *);
+void      free_bench(bench_t *);
+
+#endif
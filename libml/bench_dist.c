@@ -0,0 +1,106 @@
+/*!
+ * \file bench_dist.c
+ * \brief Micro-benchmark des noyaux de distance: temps par
+ * appel de chaque jeu d'instructions supporté et accélération
+ * par rapport à la version scalaire, pour plusieurs dimensions.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "data.h"
+#include "dist.h"
+#include "rng.h"
+
+#define BENCH_BYTES (256 << 10) // taille des données parcourues (tient dans le cache L2)
+#define BENCH_NS 20000000.0     // durée minimale d'une mesure (ns)
+
+static const int dims[] = { 2, 3, 4, 8, 16, 32, 64, 100, 128, 256, 512, 1024 };
+
+/** \brief Renvoie l'horloge monotone en nanosecondes */
+static double now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/** \brief Mesure le temps moyen d'un appel du noyau en parcourant
+ * toutes les lignes des données, jusqu'à atteindre BENCH_NS.
+ *
+ * \param fn noyau de distance
+ * \param data données
+ * \param q vecteur requête
+ * \param sink somme des résultats (empêche l'élimination des appels)
+ *
+ * \return le temps moyen d'un appel (ns)
+ */
+static double time_kernel(double (*fn)(const ml_real_t *, const ml_real_t *, int),
+  data_t * data, const ml_real_t * q, double * sink) {
+  double t0 = now_ns(), t;
+  long calls = 0;
+  int i;
+
+  do {
+    for(i = 0; i < data->n; i++)
+      *sink += fn(DATA_ROW(data, i), q, data->d);
+    calls += data->n;
+  } while((t = now_ns() - t0) < BENCH_NS);
+
+  return t / calls;
+}
+
+/** \brief Renvoie le noyau choisi dans un jeu de noyaux.
+ *
+ * \param k jeu de noyaux
+ * \param op 0: distance euclidienne au carré, 1: Manhattan, 2: produit scalaire
+ */
+static double (*kernel_op(const dist_kernels_t * k, int op))(const ml_real_t *, const ml_real_t *, int) {
+  return op == 0 ? k->sq_l2 : op == 1 ? k->l1 : k->dot;
+}
+
+int main(void) {
+  const char * ops[] = { "sq_l2", "l1", "dot" };
+  int nb_dims = sizeof(dims) / sizeof(*dims), nb_k = dist_nb_kernels();
+  int op, di, k, i, j, n;
+  double sink = 0, base, t, ref, res;
+  rng_t rng;
+
+  printf("ml_real_t: %s, selected: %s\n", sizeof(ml_real_t) == sizeof(float) ? "float" : "double",
+    ml_dist.name);
+
+  for(op = 0; op < 3; op++) {
+    printf("\n%-6s %5s", ops[op], "d");
+    for(k = 0; k < nb_k; k++)
+      if(dist_kernels(k))
+        printf(" %18s", dist_kernels(k)->name);
+    printf("\n");
+
+    for(di = 0; di < nb_dims; di++) {
+      n = BENCH_BYTES / (dims[di] * sizeof(ml_real_t));
+      data_t * data = init_data(n, dims[di]);
+      ml_real_t * q = DATA_ROW(data, n - 1);
+      rng_init(&rng, di + 1, 0);
+      for(i = 0; i < n; i++)
+        for(j = 0; j < dims[di]; j++)
+          DATA_ROW(data, i)[j] = rng_uniform(&rng) - 0.5;
+
+      printf("%-6s %5d", "", dims[di]);
+      ref = kernel_op(dist_kernels(0), op)(DATA_ROW(data, 0), q, dims[di]);
+      base = time_kernel(kernel_op(dist_kernels(0), op), data, q, &sink);
+      for(k = 0; k < nb_k; k++) {
+        if(!dist_kernels(k))
+          continue;
+        res = kernel_op(dist_kernels(k), op)(DATA_ROW(data, 0), q, dims[di]);
+        if(fabs(res - ref) > 1e-4 * (fabs(ref) + 1))
+          fprintf(stderr, "%s %s d=%d: %g != %g\n", dist_kernels(k)->name, ops[op], dims[di], res, ref);
+        t = k ? time_kernel(kernel_op(dist_kernels(k), op), data, q, &sink) : base;
+        printf(" %8.2f ns %5.1fx", t, base / t);
+      }
+      printf("\n");
+      free_data(data);
+    }
+  }
+
+  return sink == 0.123456789;
+}
@@ -0,0 +1,868 @@
+/*!
+ * \file data.c
+ * \brief Fichier comprenant les fonctionnalités
+ * de chargement des données (CSV ou binaire), leur
+ * stockage et leur écriture au format binaire, partagées
+ * par kmeans, knn, mlp, som et csv2bin.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#define _GNU_SOURCE
+#include <assert.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <locale.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "data.h"
+#include "prof.h"
+
+#define CSV_CHUNK_SZ (1 << 20) // taille minimale d'un morceau de fichier CSV (octets)
+
+/** \brief Hache une étiquette (FNV-1a).
+ *
+ * \param s début de l'étiquette
+ * \param len taille de l'étiquette
+ *
+ * \return la valeur de hachage
+ */
+static unsigned int hash_label(const char * s, size_t len) {
+  unsigned int h = 2166136261u;
+  while(len--) {
+    h ^= (unsigned char)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+/** \brief Initialise le dictionnaire des étiquettes.
+ *
+ * \return le dictionnaire vide
+ */
+labels_t * init_labels(void) {
+  labels_t * labels = (labels_t *)calloc(1, sizeof(*labels));
+  assert(labels);
+
+  labels->cap = 16;
+  labels->table = (int *)calloc(labels->cap, sizeof(*labels->table));
+  assert(labels->table);
+  labels->refs = 1;
+
+  return labels;
+}
+
+/** \brief Double la taille de la table de hachage du
+ * dictionnaire et y replace les étiquettes.
+ *
+ * \param labels dictionnaire des étiquettes
+ */
+static void grow_labels(labels_t * labels) {
+  int id, i, mask;
+
+  free(labels->table);
+  labels->cap *= 2;
+  labels->table = (int *)calloc(labels->cap, sizeof(*labels->table));
+  assert(labels->table);
+
+  mask = labels->cap - 1;
+  for(id = 0; id < labels->size; id++) {
+    i = hash_label(labels->names[id], strlen(labels->names[id])) & mask;
+    while(labels->table[i]) i = (i + 1) & mask;
+    labels->table[i] = id + 1;
+  }
+}
+
+/** \brief Renvoie l'identifiant de l'étiquette donnée, en
+ * l'ajoutant au dictionnaire si elle n'y est pas encore. Les
+ * identifiants sont attribués dans l'ordre d'apparition (0, 1, ...).
+ *
+ * \param labels dictionnaire des étiquettes
+ * \param s début de l'étiquette (non terminée par '\0')
+ * \param len taille de l'étiquette
+ *
+ * \return l'identifiant de l'étiquette
+ */
+int add_label(labels_t * labels, const char * s, size_t len) {
+  int id, i, mask = labels->cap - 1;
+
+  for(i = hash_label(s, len) & mask; labels->table[i]; i = (i + 1) & mask) {
+    id = labels->table[i] - 1;
+    if(!strncmp(labels->names[id], s, len) && labels->names[id][len] == '\0')
+      return id;
+  }
+
+  if(!(labels->size & (labels->size - 1))) {
+    labels->names = (char **)realloc(labels->names,
+      (labels->size ? 2 * labels->size : 1) * sizeof(*labels->names));
+    assert(labels->names);
+  }
+  labels->names[labels->size] = strndup(s, len);
+  assert(labels->names[labels->size]);
+  labels->table[i] = labels->size + 1;
+  id = labels->size++;
+
+  if(2 * labels->size > labels->cap)
+    grow_labels(labels);
+  return id;
+}
+
+/** \brief Libère le dictionnaire des étiquettes lorsqu'il n'est
+ * plus partagé par aucun ensemble de données.
+ *
+ * \param labels dictionnaire des étiquettes
+ */
+void free_labels(labels_t * labels) {
+  if(labels && !--labels->refs) {
+    int i;
+    for(i = 0; i < labels->size; i++)
+      free(labels->names[i]);
+    free(labels->names);
+    free(labels->table);
+    free(labels);
+  }
+}
+
+/** \brief Alloue un ensemble de données de n lignes et d valeurs:
+ * un unique bloc aligné dont chaque ligne est complétée par des 0
+ * jusqu'au pas (stride).
+ *
+ * \param n nombre de données
+ * \param d nombre de valeurs par donnée
+ *
+ * \return l'ensemble de données
+ */
+data_t * init_data(int n, int d) {
+  data_t * data = (data_t *)calloc(1, sizeof(*data));
+  assert(data);
+
+  data->n = n;
+  data->d = d;
+  data->stride = (d + DATA_SIMD_WIDTH - 1) / DATA_SIMD_WIDTH * DATA_SIMD_WIDTH;
+
+  if(posix_memalign((void **)&data->v, DATA_ALIGN,
+      (size_t)n * data->stride * sizeof(*data->v))) {
+    fprintf(stderr, "Can't allocate %d x %d data\n", n, d);
+    exit(1);
+  }
+  data->label = (int *)malloc(n * sizeof(*data->label));
+  assert(data->label);
+
+  int i;
+  if(data->stride > d)
+    for(i = 0; i < n; i++)
+      memset(DATA_ROW(data, i) + d, 0, (data->stride - d) * sizeof(*data->v));
+
+  return data;
+}
+
+/** \brief Structure représentant un morceau du fichier CSV,
+ * délimité par des fins de ligne et parsé par un thread */
+typedef struct chunk chunk_t;
+struct chunk {
+  const char * begin; // début du morceau
+  const char * end;   // fin du morceau
+  int from;           // indice de la première donnée du morceau
+  int rows;           // nombre de données du morceau
+  labels_t * labels;  // dictionnaire local des étiquettes
+  int * ids;          // identifiants globaux des étiquettes locales
+  data_t * data;      // données
+  int nb_val;         // nombre de valeurs par donnée
+  int label;          // présence de l'étiquette (CSV_LABEL ou CSV_LABEL_OPTIONAL)
+  char * filename;    // nom du fichier
+};
+
+/** \brief Puissances de 10 représentables exactement en double */
+static const double pow10_tab[] = {
+  1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+/** \brief Locale "C" utilisée lorsqu'un nombre ne peut pas être
+ * converti exactement par parse_double */
+static locale_t c_locale;
+
+/** \brief Convertit un nombre décimal en double sans dépasser la fin
+ * du morceau et indépendamment de la locale. Les nombres d'au plus
+ * 19 chiffres significatifs dont la mantisse tient sur 53 bits et
+ * dont l'exposant décimal est dans [-22, 22] sont convertis
+ * exactement par une seule multiplication ou division; les autres
+ * sont confiés à strtod_l.
+ *
+ * \param p début du nombre
+ * \param end fin du morceau
+ * \param val valeur convertie
+ *
+ * \return la position qui suit le nombre, NULL si aucun nombre
+ */
+static const char * parse_double(const char * p, const char * end, double * val) {
+  const char * s;
+  uint64_t mant = 0;
+  int neg = 0, digits = 0, exp10 = 0, exact = 1, e = 0, eneg = 0;
+  double v;
+
+  while(p < end && (*p == ' ' || *p == '\t')) p++;
+  s = p;
+  if(p < end && (*p == '-' || *p == '+')) neg = *p++ == '-';
+
+  for(; p < end && (unsigned)(*p - '0') < 10; p++, digits++) {
+    if(mant < 1000000000000000000ULL) mant = mant * 10 + (*p - '0');
+    else { exp10++; exact &= *p == '0'; }
+  }
+  if(p < end && *p == '.') {
+    for(p++; p < end && (unsigned)(*p - '0') < 10; p++, digits++) {
+      if(mant < 1000000000000000000ULL) { mant = mant * 10 + (*p - '0'); exp10--; }
+      else exact &= *p == '0';
+    }
+  }
+  if(!digits)
+    return NULL;
+
+  if(p + 1 < end && (*p == 'e' || *p == 'E')) {
+    const char * q = p + 1;
+    if(*q == '-' || *q == '+') eneg = *q++ == '-';
+    if(q < end && (unsigned)(*q - '0') < 10) {
+      for(; q < end && (unsigned)(*q - '0') < 10; q++)
+        if(e < 100000) e = e * 10 + (*q - '0');
+      exp10 += eneg ? -e : e;
+      p = q;
+    }
+  }
+
+  if(exact && mant <= (1ULL << 53) && exp10 >= -22 && exp10 <= 22) {
+    v = (double)mant;
+    v = exp10 < 0 ? v / pow10_tab[-exp10] : v * pow10_tab[exp10];
+  } else {
+    char buf[128], * tok = p - s < (long)sizeof(buf) ? buf : (char *)malloc(p - s + 1);
+    assert(tok);
+    memcpy(tok, s, p - s);
+    tok[p - s] = '\0';
+    v = strtod_l(tok, NULL, c_locale);
+    if(tok != buf) free(tok);
+    neg = 0;
+  }
+
+  *val = neg ? -v : v;
+  return p;
+}
+
+/** \brief Compte le nombre de lignes non vides d'un morceau du
+ * fichier afin d'allouer les données en une seule fois.
+ *
+ * \param buf début du morceau
+ * \param sz taille du morceau
+ *
+ * \return le nombre de lignes non vides
+ */
+static size_t count_rows(const char * buf, size_t sz) {
+  const char * p = buf, * end = buf + sz, * eol;
+  size_t rows = 0;
+
+  while(p < end) {
+    eol = (const char *)memchr(p, '\n', end - p);
+    if(!eol) eol = end;
+    if(eol - p > 1 || (eol - p == 1 && *p != '\r'))
+      rows++;
+    p = eol + 1;
+  }
+  return rows;
+}
+
+/** \brief Compte le nombre de valeurs par donnée à partir de la
+ * première ligne non vide du fichier CSV (tous les champs sauf
+ * l'étiquette).
+ *
+ * \param buf contenu du fichier
+ * \param sz taille du fichier
+ *
+ * \return le nombre de valeurs
+ */
+static int count_values(const char * buf, size_t sz) {
+  const char * p = buf, * end = buf + sz;
+  int nb_val = 0;
+
+  while(p < end && (*p == '\n' || *p == '\r')) p++;
+  for(; p < end && *p != '\n'; p++)
+    if(*p == ',') nb_val++;
+  return nb_val;
+}
+
+/** \brief Compte les lignes d'un morceau (exécuté par un thread).
+ *
+ * \param arg morceau du fichier (chunk_t)
+ */
+static void * count_chunk(void * arg) {
+  chunk_t * ck = (chunk_t *)arg;
+  size_t rows = count_rows(ck->begin, ck->end - ck->begin);
+
+  if(rows > INT_MAX) {
+    fprintf(stderr, "Too many rows in file %s\n", ck->filename);
+    exit(1);
+  }
+  ck->rows = rows;
+  return NULL;
+}
+
+/** \brief Parse les lignes d'un morceau directement vers le bloc de
+ * données (exécuté par un thread). Les étiquettes reçoivent un
+ * identifiant dans le dictionnaire local du morceau. Chaque ligne
+ * doit avoir exactement nb_val valeurs suivies de l'étiquette; avec
+ * CSV_LABEL_OPTIONAL, une ligne de nb_val valeurs seules reçoit
+ * l'étiquette vide.
+ *
+ * \param arg morceau du fichier (chunk_t)
+ */
+static void * parse_chunk(void * arg) {
+  chunk_t * ck = (chunk_t *)arg;
+  const char * p, * eol, * tok, * eor;
+  int line = ck->from, j;
+  size_t len;
+  ml_real_t * row;
+  double val;
+
+  ck->labels = init_labels();
+  for(p = ck->begin; p < ck->end; p = eol + 1) {
+    eol = (const char *)memchr(p, '\n', ck->end - p);
+    if(!eol) eol = ck->end;
+    len = eol - p;
+    if(len && p[len - 1] == '\r') len--;
+    if(!len) continue;
+
+    eor = p + len;
+    row = DATA_ROW(ck->data, line);
+    for(tok = p, j = 0; j < ck->nb_val; j++) {
+      if(j && (tok >= eor || *tok++ != ',')) {
+        fprintf(stderr, "Bad number of values in file %s (line %d): %d expected\n",
+          ck->filename, line + 1, ck->nb_val);
+        exit(1);
+      }
+      tok = parse_double(tok, eor, &val);
+      if(!tok) {
+        fprintf(stderr, "Error while reading file %s (line %d)\n", ck->filename, line + 1);
+        exit(1);
+      }
+      row[j] = val;
+    }
+    while(tok < eor && (*tok == ' ' || *tok == '\t')) tok++;
+
+    // l'étiquette est l'unique champ qui suit les valeurs
+    if(tok == eor && ck->label == CSV_LABEL_OPTIONAL)
+      ck->data->label[line] = add_label(ck->labels, eor, 0);
+    else if(tok < eor && *tok == ',' && !memchr(tok + 1, ',', eor - tok - 1))
+      ck->data->label[line] = add_label(ck->labels, tok + 1, eor - tok - 1);
+    else {
+      fprintf(stderr, "Bad number of values in file %s (line %d): %d expected\n",
+        ck->filename, line + 1, ck->nb_val);
+      exit(1);
+    }
+    line++;
+  }
+  return NULL;
+}
+
+/** \brief Remplace les identifiants locaux des étiquettes d'un
+ * morceau par les identifiants globaux (exécuté par un thread).
+ *
+ * \param arg morceau du fichier (chunk_t)
+ */
+static void * remap_chunk(void * arg) {
+  chunk_t * ck = (chunk_t *)arg;
+  int * label = ck->data->label + ck->from, i;
+
+  for(i = 0; i < ck->rows; i++)
+    label[i] = ck->ids[label[i]];
+  return NULL;
+}
+
+/** \brief Exécute une fonction sur chaque morceau, chacun dans
+ * son propre thread.
+ *
+ * \param fn fonction à exécuter
+ * \param chunks morceaux du fichier
+ * \param nb_chunks nombre de morceaux
+ */
+static void run_chunks(void * (*fn)(void *), chunk_t * chunks, int nb_chunks) {
+  pthread_t * threads = (pthread_t *)malloc(nb_chunks * sizeof(*threads));
+  assert(threads);
+  int i;
+
+  for(i = 1; i < nb_chunks; i++)
+    if(pthread_create(&threads[i], NULL, fn, &chunks[i])) {
+      fprintf(stderr, "Can't create thread\n");
+      exit(1);
+    }
+  fn(&chunks[0]);
+  for(i = 1; i < nb_chunks; i++)
+    pthread_join(threads[i], NULL);
+
+  free(threads);
+}
+
+/** \brief Parse le contenu d'un fichier CSV en parallèle: le fichier
+ * est découpé en morceaux sur des fins de ligne, les lignes de chaque
+ * morceau sont comptées puis parsées par un thread directement vers
+ * le bloc de données alloué une seule fois, dans l'ordre du fichier.
+ * Les dictionnaires locaux des étiquettes sont ensuite fusionnés
+ * dans l'ordre des morceaux, ce qui conserve l'ordre d'apparition.
+ *
+ * \param buf contenu du fichier
+ * \param sz taille du fichier
+ * \param filename nom du fichier
+ * \param nb_val nombre de valeurs par donnée (déduit de la
+ * première ligne si nul)
+ * \param label présence de l'étiquette (CSV_LABEL ou CSV_LABEL_OPTIONAL)
+ *
+ * \return la structure de forme data_t qui représente
+ * les données formalisées
+ */
+static data_t * read_csv(const char * buf, size_t sz, char * filename, int nb_val, int label) {
+  long nb_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  int nb_chunks = sz / CSV_CHUNK_SZ + 1, i, l;
+  size_t rows = 0;
+  const char * p = buf, * q;
+
+  if(nb_cpus < 1) nb_cpus = 1;
+  if(nb_chunks > nb_cpus) nb_chunks = nb_cpus;
+
+  if(nb_val <= 0 && !(nb_val = count_values(buf, sz))) {
+    fprintf(stderr, "Error while reading file %s\n", filename);
+    exit(1);
+  }
+
+  if(!c_locale) {
+    c_locale = newlocale(LC_ALL_MASK, "C", (locale_t)0);
+    assert(c_locale);
+  }
+
+  chunk_t * chunks = (chunk_t *)calloc(nb_chunks, sizeof(*chunks));
+  assert(chunks);
+  for(i = 0; i < nb_chunks; i++) {
+    chunks[i].begin = p;
+    q = i == nb_chunks - 1 ? buf + sz : buf + sz / nb_chunks * (i + 1);
+    if(q < p) q = p;
+    q = q < buf + sz ? (const char *)memchr(q, '\n', buf + sz - q) : NULL;
+    p = chunks[i].end = q ? q + 1 : buf + sz;
+    chunks[i].nb_val = nb_val;
+    chunks[i].label = label;
+    chunks[i].filename = filename;
+  }
+
+  run_chunks(count_chunk, chunks, nb_chunks);
+  for(i = 0; i < nb_chunks; i++) {
+    chunks[i].from = rows;
+    rows += chunks[i].rows;
+  }
+
+  if(!rows || rows > INT_MAX) {
+    fprintf(stderr, "Error while reading file %s\n", filename);
+    exit(1);
+  }
+
+  data_t * data = init_data(rows, nb_val);
+  data->labels = init_labels();
+  for(i = 0; i < nb_chunks; i++)
+    chunks[i].data = data;
+
+  run_chunks(parse_chunk, chunks, nb_chunks);
+
+  for(i = 0; i < nb_chunks; i++) {
+    chunks[i].ids = (int *)malloc((chunks[i].labels->size + 1) * sizeof(*chunks[i].ids));
+    assert(chunks[i].ids);
+    for(l = 0; l < chunks[i].labels->size; l++)
+      chunks[i].ids[l] = add_label(data->labels, chunks[i].labels->names[l],
+        strlen(chunks[i].labels->names[l]));
+  }
+
+  run_chunks(remap_chunk, chunks, nb_chunks);
+
+  for(i = 0; i < nb_chunks; i++) {
+    free_labels(chunks[i].labels);
+    free(chunks[i].ids);
+  }
+  free(chunks);
+
+  return data;
+}
+
+/** \brief Utilise directement un fichier au format binaire
+ * projeté en mémoire: le bloc de données et les identifiants
+ * d'étiquettes ne sont pas recopiés, seul le dictionnaire des
+ * étiquettes est reconstruit. Si le type ou le pas des valeurs du
+ * fichier ne correspondent pas à ceux compilés (ml_real_t), les
+ * données sont converties dans un bloc alloué. Un fichier dont les
+ * positions sont incohérentes, dont le dictionnaire contient des
+ * étiquettes en double ou dont un identifiant d'étiquette sort du
+ * dictionnaire est rejeté.
+ *
+ * \param buf contenu du fichier
+ * \param sz taille du fichier
+ * \param filename nom du fichier
+ * \param nb_val nombre de valeurs par donnée (lu dans l'en-tête
+ * si nul)
+ *
+ * \return la structure de forme data_t qui représente
+ * les données formalisées
+ */
+static data_t * read_bin(char * buf, size_t sz, char * filename, int nb_val) {
+  const bin_header_t * hdr = (const bin_header_t *)buf;
+  size_t esz = hdr->dtype == BIN_FLOAT ? sizeof(float) : sizeof(double);
+  const char * name, * end;
+  size_t len, r;
+  uint32_t i;
+  data_t * data;
+
+  if(
+    (hdr->dtype != BIN_DOUBLE && hdr->dtype != BIN_FLOAT) ||
+    !hdr->dims || (nb_val > 0 && hdr->dims != (uint32_t)nb_val) ||
+    hdr->stride < hdr->dims ||
+    !hdr->rows || hdr->rows > INT_MAX ||
+    hdr->labels_off < sizeof(*hdr) || hdr->data_off < hdr->labels_off ||
+    hdr->data_off % DATA_ALIGN || hdr->label_off > sz ||
+    hdr->label_off < hdr->data_off || hdr->label_off % sizeof(int32_t) ||
+    (hdr->label_off - hdr->data_off) / (hdr->stride * esz) < hdr->rows ||
+    (sz - hdr->label_off) / sizeof(int32_t) < hdr->rows
+  ) {
+    fprintf(stderr, "Bad binary file %s\n", filename);
+    exit(1);
+  }
+
+  if(hdr->dtype == BIN_DTYPE && hdr->stride % DATA_SIMD_WIDTH == 0) {
+    data = (data_t *)calloc(1, sizeof(*data));
+    assert(data);
+    data->n = hdr->rows;
+    data->d = hdr->dims;
+    data->stride = hdr->stride;
+    data->v = (ml_real_t *)(buf + hdr->data_off);
+    data->label = (int *)(buf + hdr->label_off);
+    data->map = buf;
+    data->map_sz = sz;
+  } else {
+    const float * vf = (const float *)(buf + hdr->data_off);
+    const double * vd = (const double *)(buf + hdr->data_off);
+    data = init_data(hdr->rows, hdr->dims);
+    for(r = 0; r < hdr->rows; r++)
+      for(i = 0; i < hdr->dims; i++)
+        DATA_ROW(data, r)[i] = hdr->dtype == BIN_FLOAT ?
+          vf[r * hdr->stride + i] : vd[r * hdr->stride + i];
+    memcpy(data->label, buf + hdr->label_off, hdr->rows * sizeof(*data->label));
+  }
+
+  data->labels = init_labels();
+  name = buf + hdr->labels_off;
+  end = buf + hdr->data_off;
+  for(i = 0; i < hdr->nb_labels; i++) {
+    len = strnlen(name, end - name);
+    if(name + len == end) {
+      fprintf(stderr, "Bad binary file %s\n", filename);
+      exit(1);
+    }
+    add_label(data->labels, name, len);
+    name += len + 1;
+  }
+
+  // étiquettes en double (fusionnées par add_label) ou identifiants hors du dictionnaire
+  if((uint32_t)data->labels->size != hdr->nb_labels) {
+    fprintf(stderr, "Bad binary file %s\n", filename);
+    exit(1);
+  }
+  for(r = 0; r < hdr->rows; r++)
+    if(data->label[r] < 0 || (uint32_t)data->label[r] >= hdr->nb_labels) {
+      fprintf(stderr, "Bad binary file %s\n", filename);
+      exit(1);
+    }
+
+  if(!data->map)
+    munmap(buf, sz);
+
+  return data;
+}
+
+/** \brief Lire le fichier de données, au format CSV ou au format
+ * binaire (détecté par sa signature), projeté en mémoire (mmap).
+ *
+ * \param filename nom du fichier
+ * \param nb_val nombre de valeurs par donnée (déduit du fichier si nul)
+ * \param label présence de l'étiquette dans un fichier CSV
+ *
+ * \return la structure de forme data_t qui représente
+ * les données formalisées
+ */
+static data_t * map_data(char * filename, int nb_val, int label) {
+  PROF_BEGIN(load, "load_data");
+  int fd = open(filename, O_RDONLY);
+  if(fd < 0) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    exit(1);
+  }
+
+  struct stat st;
+  if(fstat(fd, &st) < 0 || st.st_size == 0) {
+    fprintf(stderr, "Error while reading file %s\n", filename);
+    exit(1);
+  }
+
+  // projection privée: les données peuvent être modifiées (normalize)
+  // sans toucher au fichier
+  size_t sz = st.st_size;
+  char * buf = (char *)mmap(NULL, sz, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  if(buf == MAP_FAILED) {
+    fprintf(stderr, "Can't map file %s\n", filename);
+    exit(1);
+  }
+  close(fd);
+
+  data_t * data;
+  if(sz >= sizeof(bin_header_t) && !memcmp(buf, BIN_MAGIC, 8)) {
+    data = read_bin(buf, sz, filename, nb_val);
+  } else {
+    madvise(buf, sz, MADV_SEQUENTIAL);
+    data = read_csv(buf, sz, filename, nb_val, label);
+    munmap(buf, sz);
+  }
+
+  PROF_END(load);
+  return data;
+}
+
+/** \brief Lire le fichier de données étiquetées (CSV ou binaire).
+ *
+ * \param filename nom du fichier
+ * \param nb_val nombre de valeurs par donnée (déduit du fichier si nul)
+ *
+ * \return la structure de forme data_t qui représente
+ * les données formalisées
+ */
+data_t * load_data(char * filename, int nb_val) {
+  return map_data(filename, nb_val, CSV_LABEL);
+}
+
+/** \brief Lire un fichier de données dont l'étiquette est
+ * facultative (données à affecter à un modèle). Les lignes sans
+ * étiquette reçoivent l'étiquette vide.
+ *
+ * \param filename nom du fichier
+ * \param nb_val nombre de valeurs par donnée, imposé par le modèle
+ *
+ * \return la structure de forme data_t qui représente
+ * les données formalisées
+ */
+data_t * load_values(char * filename, int nb_val) {
+  return map_data(filename, nb_val, CSV_LABEL_OPTIONAL);
+}
+
+/** \brief Lit des données CSV déjà en mémoire (par exemple un lot
+ * de lignes lu sur l'entrée standard).
+ *
+ * \param buf contenu CSV (au moins une ligne non vide)
+ * \param sz taille du contenu
+ * \param name nom des données dans les messages d'erreur
+ * \param nb_val nombre de valeurs par donnée (0: déduit de la
+ * première ligne)
+ * \param label présence de l'étiquette (CSV_LABEL ou CSV_LABEL_OPTIONAL)
+ *
+ * \return les données
+ */
+data_t * parse_csv(const char * buf, size_t sz, char * name, int nb_val, int label) {
+  PROF_BEGIN(load, "load_data");
+  data_t * data = read_csv(buf, sz, name, nb_val, label);
+  PROF_END(load);
+  return data;
+}
+
+/** \brief Normalise les données.
+ *
+ * \param data ensemble de données
+ */
+void normalize(data_t * data) {
+  int i, j;
+  ml_real_t * row;
+  double sum;
+
+  if(!data->norm) {
+    data->norm = (double *)malloc(data->n * sizeof(*data->norm));
+    assert(data->norm);
+  }
+
+  for(i = 0; i < data->n; i++) {
+    row = DATA_ROW(data, i);
+    sum = 0;
+    for(j = 0; j < data->d; j++)
+      sum += pow(row[j], 2.0);
+    data->norm[i] = sqrt(sum);
+    for(j = 0; j < data->d; j++)
+      row[j] /= data->norm[i];
+  }
+}
+
+/** \brief Libère un ensemble de données.
+ *
+ * \param data ensemble de données
+ */
+void free_data(data_t * data) {
+  if(data) {
+    free_labels(data->labels);
+    if(data->map) {
+      munmap(data->map, data->map_sz);
+    } else {
+      free(data->label);
+      free(data->v);
+    }
+    free(data->norm);
+    free(data->weight);
+    free(data);
+    data = NULL;
+  }
+}
+
+/** \brief Extrait une partie des données selon l'ordre de passage
+ * donné, en recopiant les lignes de façon contiguë.
+ *
+ * \param data ensemble de données
+ * \param sh vecteur représentant l'ordre de passage des données
+ * \param from premier indice de sh à extraire
+ * \param n nombre de données à extraire
+ *
+ * \return les données extraites
+ */
+data_t * split_data(data_t * data, const int * sh, int from, int n) {
+  data_t * s = init_data(n, data->d);
+  int i;
+
+  for(i = 0; i < n; i++) {
+    memcpy(DATA_ROW(s, i), DATA_ROW(data, sh[from + i]),
+      data->stride * sizeof(*data->v));
+    s->label[i] = data->label[sh[from + i]];
+  }
+  s->labels = data->labels;
+  s->labels->refs++;
+
+  return s;
+}
+
+/** \brief Regroupe les données identiques (mêmes valeurs, quelle que
+ * soit l'étiquette): chaque ligne est hachée et comparée aux lignes
+ * distinctes déjà rencontrées. Les lignes distinctes sont recopiées
+ * dans l'ordre de leur première apparition, avec l'étiquette de
+ * celle-ci, et leur nombre de copies est rangé dans weight.
+ *
+ * \param data ensemble de données
+ * \param map indice de la ligne distincte de chaque donnée (data->n)
+ *
+ * \return les données distinctes, pondérées
+ */
+data_t * dedup_data(data_t * data, int * map) {
+  size_t row_sz = data->d * sizeof(*data->v);
+  // capacité en size_t: 2n dépasse INT_MAX pour n > 2^30
+  size_t cap = 16, mask, j;
+  int i, n = 0;
+  int * first = (int *)malloc(data->n * sizeof(*first));
+  int * weight = (int *)malloc(data->n * sizeof(*weight));
+  int * table;
+  assert(first && weight);
+
+  while(cap < 2 * (size_t)data->n)
+    cap *= 2;
+  mask = cap - 1;
+  table = (int *)calloc(cap, sizeof(*table));
+  assert(table);
+
+  for(i = 0; i < data->n; i++) {
+    const ml_real_t * v = DATA_ROW(data, i);
+    for(j = hash_label((const char *)v, row_sz) & mask; table[j]; j = (j + 1) & mask)
+      if(!memcmp(DATA_ROW(data, first[table[j] - 1]), v, row_sz))
+        break;
+    if(!table[j]) {
+      first[n] = i;
+      weight[n] = 0;
+      table[j] = ++n;
+    }
+    map[i] = table[j] - 1;
+    weight[map[i]]++;
+  }
+  free(table);
+
+  data_t * s = split_data(data, first, 0, n);
+  s->weight = (int *)realloc(weight, n * sizeof(*weight));
+  assert(s->weight);
+  free(first);
+
+  return s;
+}
+
+/** \brief Écrit l'en-tête du format binaire, le dictionnaire des
+ * étiquettes et le remplissage jusqu'au bloc de données: il reste à
+ * écrire les n x stride valeurs puis les n identifiants d'étiquettes.
+ *
+ * \param fp fichier ouvert en écriture
+ * \param n nombre de données
+ * \param d nombre de valeurs par donnée
+ * \param stride pas entre deux données
+ * \param labels dictionnaire des étiquettes
+ */
+void write_bin_header(FILE * fp, int n, int d, int stride, const labels_t * labels) {
+  static const char zeros[DATA_ALIGN] = {0};
+  bin_header_t hdr;
+  size_t labels_sz = 0;
+  int i;
+
+  for(i = 0; i < labels->size; i++)
+    labels_sz += strlen(labels->names[i]) + 1;
+
+  memset(&hdr, 0, sizeof(hdr));
+  memcpy(hdr.magic, BIN_MAGIC, sizeof(hdr.magic));
+  hdr.dtype = BIN_DTYPE;
+  hdr.dims = d;
+  hdr.rows = n;
+  hdr.stride = stride;
+  hdr.nb_labels = labels->size;
+  hdr.labels_off = sizeof(hdr);
+  hdr.data_off = (hdr.labels_off + labels_sz + DATA_ALIGN - 1) / DATA_ALIGN * DATA_ALIGN;
+  hdr.label_off = hdr.data_off + (uint64_t)n * stride * sizeof(ml_real_t);
+
+  fwrite(&hdr, sizeof(hdr), 1, fp);
+  for(i = 0; i < labels->size; i++)
+    fwrite(labels->names[i], strlen(labels->names[i]) + 1, 1, fp);
+  fwrite(zeros, hdr.data_off - hdr.labels_off - labels_sz, 1, fp);
+}
+
+/** \brief Écrit les données au format binaire: en-tête, dictionnaire
+ * des étiquettes, bloc de données aligné puis identifiants
+ * d'étiquettes.
+ *
+ * \param data ensemble de données
+ * \param filename nom du fichier
+ */
+void write_bin(data_t * data, char * filename) {
+  FILE * fp = fopen(filename, "wb");
+  if(!fp) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    exit(1);
+  }
+
+  write_bin_header(fp, data->n, data->d, data->stride, data->labels);
+  fwrite(data->v, sizeof(*data->v) * data->stride, data->n, fp);
+  fwrite(data->label, sizeof(*data->label), data->n, fp);
+
+  if(ferror(fp) | fclose(fp)) {
+    fprintf(stderr, "Error while writing file %s\n", filename);
+    exit(1);
+  }
+}
+
+/** \brief Affiche les données.
+ *
+ * \param data ensemble de données
+ */
+void print_data(data_t * data) {
+  int i, j;
+  for(i = 0; i < data->n; i++) {
+    for(j = 0; j < data->d; j++) {
+      printf("%.1f,", DATA_ROW(data, i)[j]);
+    }
+    printf("%s\n", data->labels->names[data->label[i]]);
+  }
+}
@@ -0,0 +1,98 @@
+/*!
+ * \file data.h
+ * \brief Fichier header du fichier data.c
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#ifndef _DATA_H_
+#define _DATA_H_
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdint.h>
+
+/* Type des valeurs, choisi à la compilation (make PRECISION=float).
+ * Les sommes et les distances restent calculées en double */
+#ifdef ML_FLOAT
+typedef float ml_real_t;
+#else
+typedef double ml_real_t;
+#endif
+
+#define DATA_ALIGN 64                                  // alignement du bloc de données (octets)
+#define DATA_SIMD_WIDTH ((int)(32 / sizeof(ml_real_t))) // nombre de valeurs par registre SIMD
+
+#define CSV_LABEL 0          // CSV: le dernier champ de chaque ligne est l'étiquette
+#define CSV_LABEL_OPTIONAL 1 // CSV: étiquette facultative (nb_val champs sans étiquette, nb_val + 1 avec)
+
+#define BIN_MAGIC "MLDATA01" // signature du format binaire
+#define BIN_DOUBLE 1          // type des valeurs: double
+#define BIN_FLOAT 2           // type des valeurs: float
+#define BIN_DTYPE (sizeof(ml_real_t) == sizeof(float) ? BIN_FLOAT : BIN_DOUBLE) // type compilé
+
+/** \brief En-tête du format binaire des données (ordre des octets
+ * de la machine). Il est suivi du dictionnaire des étiquettes (chaînes
+ * terminées par '\0', dans l'ordre des identifiants), du bloc de
+ * données tel qu'en mémoire (aligné sur DATA_ALIGN octets) puis des
+ * identifiants d'étiquettes (int32). Un fichier dont le type des
+ * valeurs diffère de ml_real_t est converti au chargement */
+typedef struct bin_header bin_header_t;
+struct bin_header {
+  char magic[8];       // signature BIN_MAGIC
+  uint32_t dtype;      // type des valeurs
+  uint32_t dims;       // nombre de valeurs par donnée
+  uint64_t rows;       // nombre de données
+  uint32_t stride;     // pas entre deux données
+  uint32_t nb_labels;  // nombre d'étiquettes
+  uint64_t labels_off; // position du dictionnaire des étiquettes
+  uint64_t data_off;   // position du bloc de données
+  uint64_t label_off;  // position des identifiants d'étiquettes
+};
+
+/** \brief Structure représentant le dictionnaire des étiquettes:
+ * chaque étiquette distincte y reçoit un identifiant entier dense */
+typedef struct labels labels_t;
+struct labels {
+  char ** names; // étiquettes, indexées par identifiant
+  int * table;   // table de hachage (identifiant + 1, 0 si vide)
+  int size;      // nombre d'étiquettes
+  int cap;       // taille de la table de hachage
+  int refs;      // nombre d'ensembles de données partageant le dictionnaire
+};
+
+/** \brief Structure représentant les données: un unique bloc
+ * n x stride aligné, stocké ligne par ligne, où le pas (stride)
+ * correspond au nombre de valeurs arrondi à la largeur SIMD
+ * (les valeurs de remplissage valent 0) */
+typedef struct data data_t;
+struct data {
+  ml_real_t * v;     // bloc de données
+  int * label;       // identifiant de l'étiquette de chaque donnée
+  labels_t * labels; // dictionnaire des étiquettes
+  double * norm;     // norme de chaque donnée
+  int * weight;      // nombre de copies de chaque donnée (NULL: une, voir dedup_data)
+  int n;             // nombre de données
+  int d;             // nombre de valeurs par donnée
+  int stride;        // pas entre deux données
+  void * map;        // fichier binaire projeté (NULL si les données sont allouées)
+  size_t map_sz;     // taille du fichier binaire projeté
+};
+
+/** \brief Accède à la i-ème donnée */
+#define DATA_ROW(data, i) ((data)->v + (size_t)(i) * (data)->stride)
+
+labels_t * init_labels(void);
+int        add_label(labels_t *, const char *, size_t);
+void       free_labels(labels_t *);
+data_t *   init_data(int, int);
+data_t *   load_data(char *, int);
+data_t *   load_values(char *, int);
+data_t *   parse_csv(const char *, size_t, char *, int, int);
+data_t *   split_data(data_t *, const int *, int, int);
+data_t *   dedup_data(data_t *, int *);
+void       normalize(data_t *);
+void       write_bin_header(FILE *, int, int, int, const labels_t *);
+void       write_bin(data_t *, char *);
+void       print_data(data_t *);
+void       free_data(data_t *);
+
+#endif
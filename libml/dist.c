@@ -0,0 +1,270 @@
+/*!
+ * \file dist.c
+ * \brief Fichier comprenant les noyaux de calcul
+ * de distance entre deux vecteurs: version scalaire
+ * et versions vectorisées (SSE2, AVX2, AVX-512) choisies
+ * une seule fois au démarrage selon le processeur.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "dist.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define DIST_X86
+#endif
+
+/** \brief Distance euclidienne au carré (version scalaire).
+ *
+ * \param v vecteur v
+ * \param w vecteur w
+ * \param size taille des vecteurs v et w
+ *
+ * \return la somme des carrés des écarts
+ */
+static double sq_l2_scalar(const ml_real_t * v, const ml_real_t * w, int size) {
+  double sum = 0, d;
+  int i;
+  for(i = 0; i < size; i++) {
+    d = (double)v[i] - w[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+/** \brief Distance de Manhattan (version scalaire).
+ *
+ * \param v vecteur v
+ * \param w vecteur w
+ * \param size taille des vecteurs v et w
+ *
+ * \return la somme des valeurs absolues des écarts
+ */
+static double l1_scalar(const ml_real_t * v, const ml_real_t * w, int size) {
+  double sum = 0;
+  int i;
+  for(i = 0; i < size; i++)
+    sum += fabs((double)v[i] - w[i]);
+  return sum;
+}
+
+/** \brief Produit scalaire (version scalaire).
+ *
+ * \param v vecteur v
+ * \param w vecteur w
+ * \param size taille des vecteurs v et w
+ *
+ * \return le produit scalaire
+ */
+static double dot_scalar(const ml_real_t * v, const ml_real_t * w, int size) {
+  double sum = 0;
+  int i;
+  for(i = 0; i < size; i++)
+    sum += (double)v[i] * w[i];
+  return sum;
+}
+
+#ifdef DIST_X86
+/* Les registres contiennent des ml_real_t: en simple précision, chaque
+ * voie accumule au plus size / W termes en float et les voies sont
+ * additionnées en double */
+#ifdef ML_FLOAT
+#define SIMD(op) op##_ps
+#define M128 __m128
+#define M256 __m256
+#define M512 __m512
+#else
+#define SIMD(op) op##_pd
+#define M128 __m128d
+#define M256 __m256d
+#define M512 __m512d
+#endif
+#define LANES(bits) ((int)((bits) / 8 / sizeof(ml_real_t)))
+
+/* Sommes horizontales des registres, effectuées en double */
+#ifdef ML_FLOAT
+__attribute__((target("sse2"))) static double hsum_sse2(__m128 a) {
+  __m128d s = _mm_add_pd(_mm_cvtps_pd(a), _mm_cvtps_pd(_mm_movehl_ps(a, a)));
+  return _mm_cvtsd_f64(_mm_add_sd(s, _mm_unpackhi_pd(s, s)));
+}
+
+__attribute__((target("avx2,fma"))) static double hsum_avx2(__m256 a) {
+  __m256d s = _mm256_add_pd(_mm256_cvtps_pd(_mm256_castps256_ps128(a)),
+    _mm256_cvtps_pd(_mm256_extractf128_ps(a, 1)));
+  __m128d t = _mm_add_pd(_mm256_castpd256_pd128(s), _mm256_extractf128_pd(s, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(t, _mm_unpackhi_pd(t, t)));
+}
+
+__attribute__((target("avx512f"))) static double hsum_avx512(__m512 a) {
+  __m256 hi = _mm256_castpd_ps(_mm512_extractf64x4_pd(_mm512_castps_pd(a), 1));
+  return _mm512_reduce_add_pd(_mm512_add_pd(
+    _mm512_cvtps_pd(_mm512_castps512_ps256(a)), _mm512_cvtps_pd(hi)));
+}
+#else
+__attribute__((target("sse2"))) static double hsum_sse2(__m128d a) {
+  return _mm_cvtsd_f64(_mm_add_sd(a, _mm_unpackhi_pd(a, a)));
+}
+
+__attribute__((target("avx2,fma"))) static double hsum_avx2(__m256d a) {
+  __m128d t = _mm_add_pd(_mm256_castpd256_pd128(a), _mm256_extractf128_pd(a, 1));
+  return _mm_cvtsd_f64(_mm_add_sd(t, _mm_unpackhi_pd(t, t)));
+}
+
+__attribute__((target("avx512f"))) static double hsum_avx512(__m512d a) {
+  return _mm512_reduce_add_pd(a);
+}
+#endif
+
+/* SSE2: pas de FMA, multiplication puis addition */
+#define ISA sse2
+#define ATTR __attribute__((target("sse2")))
+#define W LANES(128)
+#define VEC M128
+#define ZERO SIMD(_mm_setzero)
+#define LOAD SIMD(_mm_loadu)
+#define SUB SIMD(_mm_sub)
+#define MUL SIMD(_mm_mul)
+#define ADD SIMD(_mm_add)
+#define FMADD(a, b, c) ADD(MUL(a, b), c)
+#define ABS(a) SIMD(_mm_andnot)(SIMD(_mm_set1)(-0.0), a)
+#define HSUM hsum_sse2
+#include "dist_impl.h"
+#undef ISA
+#undef ATTR
+#undef W
+#undef VEC
+#undef ZERO
+#undef LOAD
+#undef SUB
+#undef MUL
+#undef ADD
+#undef FMADD
+#undef ABS
+#undef HSUM
+
+/* AVX2 + FMA */
+#define ISA avx2
+#define ATTR __attribute__((target("avx2,fma")))
+#define W LANES(256)
+#define VEC M256
+#define ZERO SIMD(_mm256_setzero)
+#define LOAD SIMD(_mm256_loadu)
+#define SUB SIMD(_mm256_sub)
+#define MUL SIMD(_mm256_mul)
+#define ADD SIMD(_mm256_add)
+#define FMADD SIMD(_mm256_fmadd)
+#define ABS(a) SIMD(_mm256_andnot)(SIMD(_mm256_set1)(-0.0), a)
+#define HSUM hsum_avx2
+#include "dist_impl.h"
+#undef ISA
+#undef ATTR
+#undef W
+#undef VEC
+#undef ZERO
+#undef LOAD
+#undef SUB
+#undef MUL
+#undef ADD
+#undef FMADD
+#undef ABS
+#undef HSUM
+
+/* AVX-512F: la fin du vecteur est chargée sous masque */
+#define ISA avx512
+#define ATTR __attribute__((target("avx512f")))
+#define W LANES(512)
+#define VEC M512
+#define ZERO SIMD(_mm512_setzero)
+#define LOAD SIMD(_mm512_loadu)
+#define LOADMASK SIMD(_mm512_maskz_loadu)
+#define SUB SIMD(_mm512_sub)
+#define MUL SIMD(_mm512_mul)
+#define ADD SIMD(_mm512_add)
+#define FMADD SIMD(_mm512_fmadd)
+#define ABS SIMD(_mm512_abs)
+#define HSUM hsum_avx512
+#include "dist_impl.h"
+#undef ISA
+#undef ATTR
+#undef W
+#undef VEC
+#undef ZERO
+#undef LOAD
+#undef LOADMASK
+#undef SUB
+#undef MUL
+#undef ADD
+#undef FMADD
+#undef ABS
+#undef HSUM
+#endif
+
+/** \brief Jeux de noyaux, du plus générique au plus rapide */
+static const dist_kernels_t kernels[] = {
+  { "scalar", sq_l2_scalar, l1_scalar, dot_scalar },
+#ifdef DIST_X86
+  { "sse2",   sq_l2_sse2,   l1_sse2,   dot_sse2 },
+  { "avx2",   sq_l2_avx2,   l1_avx2,   dot_avx2 },
+  { "avx512", sq_l2_avx512, l1_avx512, dot_avx512 },
+#endif
+};
+
+dist_kernels_t ml_dist = { "scalar", sq_l2_scalar, l1_scalar, dot_scalar };
+
+/** \brief Indique si le processeur supporte un jeu de noyaux.
+ *
+ * \param k jeu de noyaux
+ *
+ * \return 1 si le jeu d'instructions est supporté, sinon 0
+ */
+static int supported(const dist_kernels_t * k) {
+#ifdef DIST_X86
+  __builtin_cpu_init();
+  if(!strcmp(k->name, "sse2"))
+    return __builtin_cpu_supports("sse2");
+  if(!strcmp(k->name, "avx2"))
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+  if(!strcmp(k->name, "avx512"))
+    return __builtin_cpu_supports("avx512f");
+#endif
+  return 1;
+}
+
+/** \brief Renvoie le nombre de jeux de noyaux compilés.
+ *
+ * \return le nombre de jeux de noyaux
+ */
+int dist_nb_kernels(void) {
+  return sizeof(kernels) / sizeof(*kernels);
+}
+
+/** \brief Renvoie le i-ème jeu de noyaux s'il est supporté par
+ * le processeur.
+ *
+ * \param i indice du jeu de noyaux
+ *
+ * \return le jeu de noyaux, NULL s'il n'est pas supporté
+ */
+const dist_kernels_t * dist_kernels(int i) {
+  if(i < 0 || i >= dist_nb_kernels() || !supported(&kernels[i]))
+    return NULL;
+  return &kernels[i];
+}
+
+/** \brief Choisit au démarrage le jeu de noyaux le plus rapide
+ * supporté par le processeur, ou celui nommé par ML_ISA s'il
+ * est supporté.
+ */
+__attribute__((constructor)) static void init_dist(void) {
+  const char * isa = getenv("ML_ISA");
+  int i;
+
+  for(i = 0; i < dist_nb_kernels(); i++) {
+    if(!dist_kernels(i))
+      continue;
+    ml_dist = kernels[i];
+    if(isa && !strcmp(isa, kernels[i].name))
+      return;
+  }
+}
@@ -0,0 +1,73 @@
+/*!
+ * \file dist.h
+ * \brief Fichier header du fichier dist.c
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#ifndef _DIST_H_
+#define _DIST_H_
+
+#include <math.h>
+#include "data.h"
+#include "prof.h"
+
+/** \brief Structure représentant un jeu de noyaux de distance,
+ * implémenté pour un jeu d'instructions donné */
+typedef struct dist_kernels dist_kernels_t;
+struct dist_kernels {
+  const char * name;                                          // jeu d'instructions
+  double (*sq_l2)(const ml_real_t *, const ml_real_t *, int); // distance euclidienne au carré
+  double (*l1)(const ml_real_t *, const ml_real_t *, int);    // distance de Manhattan
+  double (*dot)(const ml_real_t *, const ml_real_t *, int);   // produit scalaire
+};
+
+/** \brief Noyaux choisis au démarrage selon le processeur (CPUID),
+ * ou imposés par la variable d'environnement ML_ISA */
+extern dist_kernels_t ml_dist;
+
+int                    dist_nb_kernels(void);
+const dist_kernels_t * dist_kernels(int);
+
+/** \brief Distance euclidienne au carré de deux vecteurs */
+static inline double sq_l2_dist(const ml_real_t * v, const ml_real_t * w, int size) {
+  PROF_COUNT(PROF_DIST, 1);
+  return ml_dist.sq_l2(v, w, size);
+}
+
+/** \brief Distance de Manhattan de deux vecteurs */
+static inline double l1_dist(const ml_real_t * v, const ml_real_t * w, int size) {
+  PROF_COUNT(PROF_DIST, 1);
+  return ml_dist.l1(v, w, size);
+}
+
+/** \brief Produit scalaire de deux vecteurs */
+static inline double dot_prod(const ml_real_t * v, const ml_real_t * w, int size) {
+  return ml_dist.dot(v, w, size);
+}
+
+/** \brief Compare deux distances euclidiennes à partir de leurs
+ * carrés. Deux carrés distincts mais très proches (écart relatif d'au
+ * plus 2^-50) peuvent avoir la même racine une fois arrondie: seules
+ * ces quasi-égalités sont départagées en calculant les racines, si bien
+ * que le résultat est celui de la comparaison des distances.
+ *
+ * \param a distance au carré a
+ * \param b distance au carré b
+ *
+ * \return -1, 0 ou 1 selon que sqrt(a) est inférieure, égale ou
+ * supérieure à sqrt(b)
+ */
+static inline int sq_dist_cmp(double a, double b) {
+  if(fabs(a - b) > 0x1p-50 * fmax(a, b))
+    return a < b ? -1 : 1;
+  a = sqrt(a);
+  b = sqrt(b);
+  return (a > b) - (a < b);
+}
+
+/** \brief Distance euclidienne de deux vecteurs */
+static inline double euclidean_dist(const ml_real_t * v, const ml_real_t * w, int size) {
+  PROF_COUNT(PROF_DIST, 1);
+  return sqrt(ml_dist.sq_l2(v, w, size));
+}
+
+#endif
@@ -0,0 +1,140 @@
+/*!
+ * \file dist_impl.h
+ * \brief Modèle des noyaux de distance vectorisés, inclus par
+ * dist.c une fois par jeu d'instructions après avoir défini
+ * ISA (suffixe des fonctions), ATTR (attribut target), W (nombre
+ * de valeurs par registre), VEC, ZERO, LOAD, SUB, MUL, ADD, FMADD,
+ * ABS, HSUM et, si le jeu d'instructions le permet, LOADMASK pour
+ * traiter la fin du vecteur sans boucle scalaire. Les vecteurs plus
+ * courts qu'un registre sont confiés à la version scalaire.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#define KERNEL__(name, isa) name##_##isa
+#define KERNEL_(name, isa) KERNEL__(name, isa)
+#define KERNEL(name) KERNEL_(name, ISA)
+
+#ifdef LOADMASK
+#define TAIL_MASK(n) ((1ULL << (n)) - 1)
+#endif
+
+/** \brief Distance euclidienne au carré de deux vecteurs.
+ *
+ * \param v vecteur v
+ * \param w vecteur w
+ * \param size taille des vecteurs v et w
+ *
+ * \return la somme des carrés des écarts
+ */
+static ATTR double KERNEL(sq_l2)(const ml_real_t * v, const ml_real_t * w, int size) {
+  VEC a0 = ZERO(), a1 = ZERO(), d0, d1;
+  double sum, d;
+  int i = 0;
+
+  if(size < W)
+    return sq_l2_scalar(v, w, size);
+
+  for(; i + 2 * W <= size; i += 2 * W) {
+    d0 = SUB(LOAD(v + i), LOAD(w + i));
+    d1 = SUB(LOAD(v + i + W), LOAD(w + i + W));
+    a0 = FMADD(d0, d0, a0);
+    a1 = FMADD(d1, d1, a1);
+  }
+  if(i + W <= size) {
+    d0 = SUB(LOAD(v + i), LOAD(w + i));
+    a0 = FMADD(d0, d0, a0);
+    i += W;
+  }
+#ifdef LOADMASK
+  if(i < size) {
+    d1 = SUB(LOADMASK(TAIL_MASK(size - i), v + i), LOADMASK(TAIL_MASK(size - i), w + i));
+    a1 = FMADD(d1, d1, a1);
+    i = size;
+  }
+#endif
+  sum = HSUM(ADD(a0, a1));
+  for(; i < size; i++) {
+    d = (double)v[i] - w[i];
+    sum += d * d;
+  }
+  return sum;
+}
+
+/** \brief Distance de Manhattan de deux vecteurs.
+ *
+ * \param v vecteur v
+ * \param w vecteur w
+ * \param size taille des vecteurs v et w
+ *
+ * \return la somme des valeurs absolues des écarts
+ */
+static ATTR double KERNEL(l1)(const ml_real_t * v, const ml_real_t * w, int size) {
+  VEC a0 = ZERO(), a1 = ZERO();
+  double sum;
+  int i = 0;
+
+  if(size < W)
+    return l1_scalar(v, w, size);
+
+  for(; i + 2 * W <= size; i += 2 * W) {
+    a0 = ADD(a0, ABS(SUB(LOAD(v + i), LOAD(w + i))));
+    a1 = ADD(a1, ABS(SUB(LOAD(v + i + W), LOAD(w + i + W))));
+  }
+  if(i + W <= size) {
+    a0 = ADD(a0, ABS(SUB(LOAD(v + i), LOAD(w + i))));
+    i += W;
+  }
+#ifdef LOADMASK
+  if(i < size) {
+    a1 = ADD(a1, ABS(SUB(LOADMASK(TAIL_MASK(size - i), v + i),
+      LOADMASK(TAIL_MASK(size - i), w + i))));
+    i = size;
+  }
+#endif
+  sum = HSUM(ADD(a0, a1));
+  for(; i < size; i++)
+    sum += fabs((double)v[i] - w[i]);
+  return sum;
+}
+
+/** \brief Produit scalaire de deux vecteurs.
+ *
+ * \param v vecteur v
+ * \param w vecteur w
+ * \param size taille des vecteurs v et w
+ *
+ * \return le produit scalaire
+ */
+static ATTR double KERNEL(dot)(const ml_real_t * v, const ml_real_t * w, int size) {
+  VEC a0 = ZERO(), a1 = ZERO();
+  double sum;
+  int i = 0;
+
+  if(size < W)
+    return dot_scalar(v, w, size);
+
+  for(; i + 2 * W <= size; i += 2 * W) {
+    a0 = FMADD(LOAD(v + i), LOAD(w + i), a0);
+    a1 = FMADD(LOAD(v + i + W), LOAD(w + i + W), a1);
+  }
+  if(i + W <= size) {
+    a0 = FMADD(LOAD(v + i), LOAD(w + i), a0);
+    i += W;
+  }
+#ifdef LOADMASK
+  if(i < size) {
+    a1 = FMADD(LOADMASK(TAIL_MASK(size - i), v + i), LOADMASK(TAIL_MASK(size - i), w + i), a1);
+    i = size;
+  }
+#endif
+  sum = HSUM(ADD(a0, a1));
+  for(; i < size; i++)
+    sum += (double)v[i] * w[i];
+  return sum;
+}
+
+#ifdef LOADMASK
+#undef TAIL_MASK
+#endif
+#undef KERNEL
+#undef KERNEL_
+#undef KERNEL__
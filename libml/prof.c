@@ -0,0 +1,319 @@
+/*!
+ * \file prof.c
+ * \brief Fichier comprenant les fonctionnalités
+ * d'instrumentation (make PROFILE=1): compteurs par thread,
+ * enregistrement des phases et rapport JSON écrit à la fin
+ * du programme, sur la sortie d'erreur ou dans le fichier
+ * désigné par la variable d'environnement ML_PROFILE_OUT.
+ * Avec ML_PERF=1, chaque thread ouvre un groupe de compteurs
+ * matériels (perf_event_open), lus au début et à la fin de chaque
+ * phase; les compteurs indisponibles (machine virtuelle, conteneur,
+ * perf_event_paranoid) sont simplement absents du rapport. À la fin
+ * d'un thread, ses compteurs sont ajoutés au total des threads
+ * terminés et ses compteurs matériels fermés.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include "prof.h"
+
+#ifdef ML_PROFILE
+
+__thread prof_block_t * prof_tls = NULL;
+int prof_perf_on = 0;
+
+static pthread_mutex_t prof_lock = PTHREAD_MUTEX_INITIALIZER;
+static prof_block_t * blocks = NULL;          // compteurs de chaque thread en cours
+static prof_block_t retired;                  // total des compteurs des threads terminés
+static int retired_avail[PERF_NB_EVENTS];     // compteurs matériels ouverts par un thread terminé
+static pthread_key_t prof_key;                // libération des compteurs à la fin d'un thread
+static int nb_threads = 0;                    // nombre de threads instrumentés
+static const char * names[PROF_MAX_PHASES];   // nom de chaque phase
+static int nb_phases = 0;                     // nombre de phases
+static uint64_t clock0;                       // compteur de cycles au démarrage
+static double ns0;                            // horloge monotone au démarrage (ns)
+static int perf_errno = 0;                    // erreur d'ouverture d'un compteur matériel
+
+static const char * counter_names[PROF_NB_COUNTERS] = {
+  "dist_evals", "reassignments", "bmu_searches", "mat_allocs", "mat_bytes"
+};
+
+/** \brief Compteurs matériels: nom, type et configuration
+ * de perf_event_open */
+static const struct {
+  const char * name;
+  uint32_t type;
+  uint64_t config;
+} perf_events[PERF_NB_EVENTS] = {
+  { "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+  { "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+  { "cache_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+  { "l1d_misses", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+    (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+  { "branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  { "page_faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS }
+};
+
+/** \brief Renvoie l'horloge monotone en nanosecondes */
+static double now_ns(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+/** \brief Ouvre le groupe de compteurs matériels du thread
+ * courant (mode utilisateur seulement). Chaque compteur qui ne
+ * peut pas être ouvert est ignoré; le premier ouvert dirige le
+ * groupe, lu en un seul appel système.
+ *
+ * \param b compteurs du thread courant
+ */
+static void perf_open(prof_block_t * b) {
+  struct perf_event_attr attr;
+  int e, fd;
+
+  for(e = 0; e < PERF_NB_EVENTS; e++) {
+    b->perf_idx[e] = -1;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perf_events[e].type;
+    attr.config = perf_events[e].config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.disabled = b->perf_fd < 0;
+    attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED |
+      PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    fd = syscall(SYS_perf_event_open, &attr, 0, -1, b->perf_fd, 0);
+    if(fd < 0) {
+      perf_errno = errno;
+      continue;
+    }
+    if(b->perf_fd < 0)
+      b->perf_fd = fd;
+    b->perf_fds[e] = fd;
+    b->perf_idx[e] = b->perf_nr++;
+  }
+
+  if(b->perf_fd >= 0)
+    ioctl(b->perf_fd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+/** \brief Lit les compteurs matériels du thread, corrigés du
+ * multiplexage (temps d'activation / temps de comptage). Les
+ * compteurs absents valent 0.
+ *
+ * \param b compteurs du thread courant
+ * \param v valeur de chaque compteur matériel
+ */
+void prof_perf_read(prof_block_t * b, uint64_t * v) {
+  uint64_t buf[3 + PERF_NB_EVENTS];
+  double scale;
+  int e;
+
+  if(b->perf_fd < 0 || read(b->perf_fd, buf, sizeof(buf)) <
+      (ssize_t)((3 + b->perf_nr) * sizeof(*buf))) {
+    memset(v, 0, PERF_NB_EVENTS * sizeof(*v));
+    return;
+  }
+
+  // buf: nombre de compteurs, temps d'activation, temps de comptage, valeurs
+  scale = buf[2] ? (double)buf[1] / buf[2] : 0;
+  for(e = 0; e < PERF_NB_EVENTS; e++)
+    v[e] = b->perf_idx[e] < 0 ? 0 : (buf[1] == buf[2] ?
+      buf[3 + b->perf_idx[e]] : (uint64_t)(buf[3 + b->perf_idx[e]] * scale));
+}
+
+/** \brief Ajoute les compteurs d'un bloc à ceux d'un autre.
+ *
+ * \param to compteurs cumulés
+ * \param from compteurs ajoutés
+ */
+static void prof_add(prof_block_t * to, const prof_block_t * from) {
+  int i, e;
+  for(i = 0; i < PROF_NB_COUNTERS; i++)
+    to->count[i] += from->count[i];
+  for(i = 0; i < PROF_MAX_PHASES; i++) {
+    to->cycles[i] += from->cycles[i];
+    to->calls[i] += from->calls[i];
+    for(e = 0; e < PERF_NB_EVENTS; e++)
+      to->perf[i][e] += from->perf[i][e];
+  }
+}
+
+/** \brief Fin d'un thread instrumenté: ses compteurs sont ajoutés
+ * au total des threads terminés et retirés de la liste, ses
+ * compteurs matériels sont fermés et son bloc est libéré.
+ *
+ * \param arg compteurs du thread (prof_block_t)
+ */
+static void prof_unregister(void * arg) {
+  prof_block_t * b = (prof_block_t *)arg, ** p;
+  int e;
+
+  pthread_mutex_lock(&prof_lock);
+  for(p = &blocks; *p != b; p = &(*p)->next);
+  *p = b->next;
+  prof_add(&retired, b);
+  for(e = 0; e < PERF_NB_EVENTS; e++)
+    retired_avail[e] |= b->perf_idx[e] >= 0;
+  pthread_mutex_unlock(&prof_lock);
+
+  for(e = 0; e < PERF_NB_EVENTS; e++)
+    if(b->perf_fds[e] >= 0)
+      close(b->perf_fds[e]);
+  prof_tls = NULL;
+  free(b);
+}
+
+/** \brief Alloue les compteurs du thread courant et les
+ * ajoute à la liste des compteurs du rapport; ils sont libérés
+ * à la fin du thread (prof_unregister).
+ *
+ * \return les compteurs du thread courant
+ */
+prof_block_t * prof_register(void) {
+  prof_block_t * b = (prof_block_t *)calloc(1, sizeof(*b));
+  assert(b);
+
+  b->perf_fd = -1;
+  memset(b->perf_idx, -1, sizeof(b->perf_idx));
+  memset(b->perf_fds, -1, sizeof(b->perf_fds));
+  if(prof_perf_on)
+    perf_open(b);
+  pthread_setspecific(prof_key, b);
+
+  pthread_mutex_lock(&prof_lock);
+  b->next = blocks;
+  blocks = b;
+  nb_threads++;
+  pthread_mutex_unlock(&prof_lock);
+
+  prof_tls = b;
+  return b;
+}
+
+/** \brief Renvoie l'identifiant d'une phase, enregistrée
+ * lors de son premier passage.
+ *
+ * \param name nom de la phase
+ *
+ * \return l'identifiant de la phase
+ */
+int prof_phase(const char * name) {
+  int id;
+
+  pthread_mutex_lock(&prof_lock);
+  for(id = 0; id < nb_phases && strcmp(names[id], name); id++);
+  if(id == nb_phases) {
+    if(nb_phases == PROF_MAX_PHASES) {
+      fprintf(stderr, "Too many profiled phases (%s)\n", name);
+      exit(1);
+    }
+    names[nb_phases++] = name;
+  }
+  pthread_mutex_unlock(&prof_lock);
+
+  return id;
+}
+
+/** \brief Écrit le rapport JSON: compteurs et, pour chaque
+ * phase, nombre d'exécutions, cycles, durée et compteurs
+ * matériels (cumulés sur tous les threads, terminés ou non). La fréquence du
+ * compteur de cycles est mesurée sur toute la durée du programme.
+ */
+static void prof_report(void) {
+  static prof_block_t total;
+  uint64_t * count = total.count, * cycles = total.cycles, * calls = total.calls;
+  uint64_t (* perf)[PERF_NB_EVENTS] = total.perf;
+  int avail[PERF_NB_EVENTS], e, first;
+  double hz = (prof_clock() - clock0) / ((now_ns() - ns0) * 1e-9);
+  const char * filename = getenv("ML_PROFILE_OUT");
+  prof_block_t * b;
+  FILE * fp = stderr;
+  int i;
+
+  if(filename && !(fp = fopen(filename, "w"))) {
+    fprintf(stderr, "Can't open file %s\n", filename);
+    return;
+  }
+
+  pthread_mutex_lock(&prof_lock);
+  total = retired;
+  memcpy(avail, retired_avail, sizeof(avail));
+  for(b = blocks; b; b = b->next) {
+    prof_add(&total, b);
+    for(e = 0; e < PERF_NB_EVENTS; e++)
+      avail[e] |= b->perf_idx[e] >= 0;
+  }
+
+  fprintf(fp, "{\n  \"threads\": %d,\n  \"clock_hz\": %.0f,\n  \"counters\": {", nb_threads, hz);
+  for(i = 0; i < PROF_NB_COUNTERS; i++)
+    fprintf(fp, "%s\n    \"%s\": %llu", i ? "," : "", counter_names[i],
+      (unsigned long long)count[i]);
+  fprintf(fp, "\n  },\n");
+  if(prof_perf_on) {
+    fprintf(fp, "  \"perf_events\": [");
+    for(e = 0, first = 1; e < PERF_NB_EVENTS; e++) {
+      if(avail[e]) {
+        fprintf(fp, "%s\"%s\"", first ? "" : ", ", perf_events[e].name);
+        first = 0;
+      }
+    }
+    fprintf(fp, "],\n");
+    if(perf_errno)
+      fprintf(fp, "  \"perf_error\": \"%s\",\n", strerror(perf_errno));
+  }
+  fprintf(fp, "  \"phases\": [");
+  for(i = 0; i < nb_phases; i++) {
+    fprintf(fp, "%s\n    {\"name\": \"%s\", \"calls\": %llu, \"cycles\": %llu, \"seconds\": %.6f",
+      i ? "," : "", names[i], (unsigned long long)calls[i], (unsigned long long)cycles[i],
+      cycles[i] / hz);
+    if(prof_perf_on) {
+      for(e = 0; e < PERF_NB_EVENTS; e++)
+        if(avail[e])
+          fprintf(fp, ", \"%s\": %llu", perf_events[e].name, (unsigned long long)perf[i][e]);
+      if(avail[PERF_CYCLES] && avail[PERF_INSTRUCTIONS] && perf[i][PERF_CYCLES])
+        fprintf(fp, ", \"ipc\": %.3f", (double)perf[i][PERF_INSTRUCTIONS] / perf[i][PERF_CYCLES]);
+    }
+    fprintf(fp, "}");
+  }
+  fprintf(fp, "\n  ]\n}\n");
+  pthread_mutex_unlock(&prof_lock);
+
+  if(fp != stderr)
+    fclose(fp);
+}
+
+/** \brief Mesure l'origine des horloges au démarrage, ouvre
+ * les compteurs matériels du thread principal si ML_PERF=1 et
+ * programme l'écriture du rapport à la fin du programme */
+__attribute__((constructor)) static void init_prof(void) {
+  const char * perf = getenv("ML_PERF");
+
+  pthread_key_create(&prof_key, prof_unregister);
+  if(perf && atoi(perf)) {
+    prof_perf_on = 1;
+    if(prof_register()->perf_fd < 0) {
+      fprintf(stderr, "perf counters unavailable (%s), timing only\n", strerror(perf_errno));
+      prof_perf_on = 0;
+    } else if(perf_errno) {
+      fprintf(stderr, "some perf counters unavailable (%s)\n", strerror(perf_errno));
+    }
+  }
+
+  clock0 = prof_clock();
+  ns0 = now_ns();
+  atexit(prof_report);
+}
+
+#endif
@@ -0,0 +1,132 @@
+/*!
+ * \file prof.h
+ * \brief Fichier header du fichier prof.c: compteurs
+ * d'instrumentation des boucles critiques, compilés
+ * seulement avec make PROFILE=1 (ML_PROFILE). Sinon, les
+ * macros PROF_* ne génèrent aucun code. Avec ML_PERF=1, les
+ * compteurs matériels (perf_event_open) sont lus autour de
+ * chaque phase.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#ifndef _PROF_H_
+#define _PROF_H_
+
+#include <stdint.h>
+
+/** \brief Compteurs d'événements */
+enum {
+  PROF_DIST,      // évaluations de distance
+  PROF_REASSIGN,  // changements de cluster (KMeans)
+  PROF_BMU,       // recherches du BMU (SOM)
+  PROF_MAT_ALLOC, // allocations de matrices (MLP)
+  PROF_MAT_BYTES, // octets alloués pour les matrices (MLP)
+  PROF_NB_COUNTERS
+};
+
+/** \brief Compteurs matériels lus par perf_event_open */
+enum {
+  PERF_CYCLES,        // cycles
+  PERF_INSTRUCTIONS,  // instructions
+  PERF_CACHE_MISSES,  // défauts du dernier niveau de cache
+  PERF_L1D_MISSES,    // défauts de lecture du cache L1 de données
+  PERF_BRANCH_MISSES, // mauvaises prédictions de branchement
+  PERF_PAGE_FAULTS,   // défauts de page (compteur logiciel)
+  PERF_NB_EVENTS
+};
+
+#define PROF_MAX_PHASES 32 // nombre maximal de phases mesurées
+
+#ifdef ML_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+
+/** \brief Structure représentant les compteurs d'un thread,
+ * additionnés à ceux des autres threads dans le rapport */
+typedef struct prof_block prof_block_t;
+struct prof_block {
+  uint64_t count[PROF_NB_COUNTERS];  // compteurs d'événements
+  uint64_t cycles[PROF_MAX_PHASES];  // cycles passés dans chaque phase
+  uint64_t calls[PROF_MAX_PHASES];   // nombre d'exécutions de chaque phase
+  uint64_t perf[PROF_MAX_PHASES][PERF_NB_EVENTS];  // compteurs matériels de chaque phase
+  uint64_t perf0[PROF_MAX_PHASES][PERF_NB_EVENTS]; // compteurs matériels au début de chaque phase
+  int perf_fd;                       // groupe de compteurs matériels du thread (-1 si absent)
+  int perf_fds[PERF_NB_EVENTS];      // descripteur de chaque compteur (-1 si absent)
+  int perf_idx[PERF_NB_EVENTS];      // position de chaque compteur dans le groupe (-1 si absent)
+  int perf_nr;                       // nombre de compteurs du groupe
+  prof_block_t * next;               // bloc du thread suivant
+};
+
+extern __thread prof_block_t * prof_tls;
+extern int prof_perf_on;
+
+prof_block_t * prof_register(void);
+int            prof_phase(const char *);
+void           prof_perf_read(prof_block_t *, uint64_t *);
+
+/** \brief Renvoie les compteurs du thread courant */
+static inline prof_block_t * prof_local(void) {
+  if(__builtin_expect(!prof_tls, 0))
+    return prof_register();
+  return prof_tls;
+}
+
+/** \brief Renvoie le compteur de cycles (TSC), ou l'horloge
+ * monotone en nanosecondes hors x86 */
+static inline uint64_t prof_clock(void) {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec * 1000000000ULL + t.tv_nsec;
+#endif
+}
+
+/** \brief Début d'une phase: enregistre son nom au premier
+ * passage, lit les compteurs matériels et renvoie la date de début */
+static inline uint64_t prof_begin(int * id, const char * name) {
+  int ph = __atomic_load_n(id, __ATOMIC_RELAXED);
+  if(__builtin_expect(ph < 0, 0)) {
+    ph = prof_phase(name);
+    __atomic_store_n(id, ph, __ATOMIC_RELAXED);
+  }
+  if(prof_perf_on) {
+    prof_block_t * b = prof_local();
+    prof_perf_read(b, b->perf0[ph]);
+  }
+  return prof_clock();
+}
+
+/** \brief Fin d'une phase: ajoute sa durée aux cycles du thread,
+ * et l'écart des compteurs matériels à ceux de la phase */
+static inline void prof_end(int id, uint64_t t0) {
+  prof_block_t * b = prof_local();
+  b->cycles[id] += prof_clock() - t0;
+  b->calls[id]++;
+  if(prof_perf_on) {
+    uint64_t v[PERF_NB_EVENTS];
+    int e;
+    prof_perf_read(b, v);
+    for(e = 0; e < PERF_NB_EVENTS; e++)
+      b->perf[id][e] += v[e] - b->perf0[id][e];
+  }
+}
+
+#define PROF_COUNT(c, n)     (prof_local()->count[c] += (n))
+#define PROF_BEGIN(ph, name) static int prof_##ph##_id = -1; \
+                             uint64_t prof_##ph##_t0 = prof_begin(&prof_##ph##_id, name)
+#define PROF_END(ph)         prof_end(prof_##ph##_id, prof_##ph##_t0)
+
+#else
+
+#define PROF_COUNT(c, n)     ((void)0)
+#define PROF_BEGIN(ph, name)
+#define PROF_END(ph)         ((void)0)
+
+#endif
+
+#endif
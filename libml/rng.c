@@ -0,0 +1,161 @@
+/*!
+ * \file rng.c
+ * \brief Fichier comprenant les fonctionnalités
+ * de tirage aléatoire: générateur xoshiro256** initialisé
+ * par une graine commune (SEED), un flux indépendant par
+ * thread, ordre de passage des données et nombres aléatoires
+ * dans un intervalle.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "rng.h"
+
+#define RNG_AUTO_STREAM (1ULL << 32) // premier flux attribué aux threads sans flux explicite
+
+static uint64_t seed = 0;                             // graine commune
+static uint64_t next_stream = RNG_AUTO_STREAM;        // prochain flux attribué automatiquement
+static __thread rng_t local;                          // générateur du thread
+static __thread int local_ready = 0;                  // générateur du thread initialisé
+
+/** \brief Initialise la graine commune à tous les flux et
+ * le flux 0 du thread appelant. Une graine nulle est remplacée
+ * par une graine tirée de l'heure et du processus (exécutions
+ * non reproductibles).
+ *
+ * \param s graine
+ */
+void init_rng(uint64_t s) {
+  seed = s ? s : ((uint64_t)time(NULL) << 20) ^ (uint64_t)getpid();
+  rng_stream(0);
+}
+
+/** \brief Renvoie la graine commune utilisée */
+uint64_t get_seed(void) {
+  return seed;
+}
+
+/** \brief Initialise un générateur sur le flux stream de la
+ * graine s: deux flux différents donnent des suites indépendantes,
+ * et un même couple (graine, flux) toujours la même suite.
+ *
+ * \param r générateur
+ * \param s graine
+ * \param stream numéro du flux
+ */
+void rng_init(rng_t * r, uint64_t s, uint64_t stream) {
+  uint64_t sm = stream;
+  int i;
+
+  sm = s ^ splitmix64(&sm);
+  for(i = 0; i < 4; i++)
+    r->s[i] = splitmix64(&sm);
+}
+
+/** \brief Place le générateur du thread appelant sur le flux
+ * stream de la graine commune. Les calculs parallèles
+ * reproductibles numérotent ainsi leurs flux (par bloc de
+ * données, par redémarrage...), indépendamment des threads.
+ *
+ * \param stream numéro du flux
+ */
+void rng_stream(uint64_t stream) {
+  rng_init(&local, seed, stream);
+  local_ready = 1;
+}
+
+/** \brief Renvoie le générateur du thread appelant. Un thread
+ * qui n'a pas choisi de flux en reçoit un qui lui est propre.
+ */
+rng_t * rng_local(void) {
+  if(!local_ready)
+    rng_stream(__atomic_fetch_add(&next_stream, 1, __ATOMIC_RELAXED));
+  return &local;
+}
+
+/** \brief Initialise le vecteur représentant l'ordre
+ * de passage des données lors de la phase d'apprentissage.
+ *
+ * \param size nombre de données
+ *
+ * \return vecteur représentant l'ordre de passage des données.
+ */
+int * init_shuffle(int size) {
+  int i;
+  int * sh = (int *)malloc(size * sizeof(*sh));
+  assert(sh);
+
+  for(i = 0; i < size; i++)
+    sh[i] = i;
+  shuffle(sh, size);
+  return sh;
+}
+
+/** \brief Mélange le vecteur représentant l'ordre de passage des données
+ * lors de la phase d'apprentissage
+ *
+ * \param sh   vecteur représentant l'ordre de passage des données
+ * \param size taille du vecteur
+ */
+void shuffle(int * sh, int size) {
+  rng_t * rng = rng_local();
+  int i, r;
+  for(i = 0; i < size; i++) {
+    r = rng_int(rng, size);
+    if(sh[i] != sh[r]) {
+      sh[i] ^= sh[r];
+      sh[r] ^= sh[i];
+      sh[i] ^= sh[r];
+    }
+  }
+}
+
+/** \brief Libère la mémoire pour le shuffle.
+ *
+ * \param sh vecteur représentant l'ordre de passage des données
+ */
+void free_shuffle(int * sh) {
+  if(sh) {
+    free(sh);
+    sh = NULL;
+  }
+}
+
+/** \brief Fonction retournant un nombre aléatoire entre deux
+ * intervalles.
+ *
+ * \param min interval minimal
+ * \param max interval maximal
+ *
+ * \return Nombre aléatoire entre les intervalles min-max.
+ */
+double rand_range(double min, double max) {
+  return rng_uniform(rng_local()) * (max - min) + min;
+}
+
+/** \brief Fonction retournant un entier aléatoire dans [0, n).
+ *
+ * \param n borne supérieure (exclue)
+ */
+int rand_int(int n) {
+  return rng_int(rng_local(), n);
+}
+
+/** \brief Générateur splitmix64: avance l'état et renvoie 64 bits
+ * pseudo-aléatoires. Un état différent par clé (graine, indice de
+ * ligne, ...) donne des suites reproductibles et indépendantes de
+ * l'ordre de génération.
+ *
+ * \param state état du générateur
+ *
+ * \return 64 bits pseudo-aléatoires
+ */
+uint64_t splitmix64(uint64_t * state) {
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
@@ -0,0 +1,56 @@
+/*!
+ * \file rng.h
+ * \brief Fichier header du fichier rng.c
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#ifndef _RNG_H_
+#define _RNG_H_
+
+#include <stdint.h>
+
+/** \brief Structure représentant l'état d'un générateur
+ * xoshiro256** */
+typedef struct rng rng_t;
+struct rng {
+  uint64_t s[4]; // état du générateur
+};
+
+void     init_rng(uint64_t);
+uint64_t get_seed(void);
+void     rng_init(rng_t *, uint64_t, uint64_t);
+void     rng_stream(uint64_t);
+rng_t *  rng_local(void);
+int *    init_shuffle(int);
+void     shuffle(int *, int);
+void     free_shuffle(int *);
+int      rand_int(int);
+double   rand_range(double, double);
+uint64_t splitmix64(uint64_t *);
+
+/** \brief Renvoie 64 bits pseudo-aléatoires (xoshiro256**) */
+static inline uint64_t rng_next(rng_t * r) {
+  uint64_t * s = r->s;
+  const uint64_t res = ((s[1] * 5) << 7 | (s[1] * 5) >> 57) * 9;
+  const uint64_t t = s[1] << 17;
+
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = s[3] << 45 | s[3] >> 19;
+  return res;
+}
+
+/** \brief Renvoie un réel uniforme dans [0, 1) */
+static inline double rng_uniform(rng_t * r) {
+  return (rng_next(r) >> 11) * 0x1p-53;
+}
+
+/** \brief Renvoie un entier uniforme dans [0, n) (méthode de
+ * Lemire: multiplication, sans division ni biais mesurable) */
+static inline int rng_int(rng_t * r, int n) {
+  return (int)(((unsigned __int128)rng_next(r) * (uint64_t)n) >> 64);
+}
+
+#endif
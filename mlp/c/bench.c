@@ -0,0 +1,64 @@
+/*!
+ * \file bench.c
+ * \brief Fichier principale concernant la mesure des
+ * performances de MLP: chargement, initialisation,
+ * apprentissage et prédiction, répétés dans le même processus.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "parser.h"
+#include "config.h"
+#include "mlp.h"
+
+int main(int argc, char *argv[]) {
+  int reps, r;
+  char * json = NULL;
+  char * filename = bench_args(argc, argv, &reps, &json);
+
+  config_t * cfg = init_config(CONFIG_FILE);
+  bench_t * b = init_bench("mlp", filename, reps);
+
+  for(r = 0; r < reps; r++) {
+    // mêmes tirages aléatoires à chaque répétition
+    init_rng(cfg->seed);
+
+    bench_start(b);
+    data_t * data = read_file(filename, cfg);
+    bench_stop(b, "load", data->n);
+
+    bench_start(b);
+    int * sh = init_shuffle(cfg->data_sz);
+    data_t * test_set = test_split(data, sh, cfg);
+    data_t * train_set = train_split(data, sh, cfg);
+    mlp_t * mlp = init_mlp(cfg);
+    bench_stop(b, "init", data->n);
+
+    bench_start(b);
+    train(mlp, train_set, cfg);
+    bench_stop(b, "train", train_set->n);
+
+    bench_start(b);
+    int * predicted = predict(mlp, test_set, cfg);
+    bench_stop(b, "predict", test_set->n);
+
+    b->rows = data->n;
+    b->dims = data->d;
+    free(predicted);
+    free_mlp(mlp);
+    free_data(train_set);
+    free_data(test_set);
+    free_data(data);
+    free_shuffle(sh);
+  }
+
+  print_bench(b);
+  if(json)
+    write_bench_json(b, json);
+
+  free_bench(b);
+  free_config(cfg);
+  return 0;
+}
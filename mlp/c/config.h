@@ -22,6 +22,7 @@ struct config {
   int data_sz;          // nombre de données
   double alpha;         // coefficient d'apprentissage
   double test_size;     // part pour les données tests
+  unsigned long long seed; // graine des tirages aléatoires (0: aléatoire)
 };
 
 #endif
\ No newline at end of file
@@ -18,8 +18,6 @@ void usage(char * exec) {
 }
 
 int main(int argc, char *argv[]) {
-  srand(time(NULL));
-
   if(argc != 2)
     usage(argv[0]);
 
@@ -30,7 +28,7 @@ int main(int argc, char *argv[]) {
          * test_set = NULL;
 
   data = read_file(argv[1], cfg);
-  // normalize(data, cfg);
+  // normalize(data);
 
   const int * sh = init_shuffle(cfg->data_sz);
   test_set = test_split(data, sh, cfg);
@@ -38,18 +36,22 @@ int main(int argc, char *argv[]) {
 
   mlp_t * mlp = init_mlp(cfg);
   train(mlp, train_set, cfg);
-  predict(mlp, data, test_set, cfg);
+  int * predicted = predict(mlp, test_set, cfg);
 
-  printf("MSE for MLP model: %.2f\n", mse(mlp, data, test_set, cfg));
+  printf("MSE for MLP model: %.2f\n", mse(mlp, test_set, predicted, cfg));
 
 #ifdef DEBUG
   print_config(cfg);
-  print_data(data, cfg);
+  print_data(data);
 #endif
   
   free_config(cfg);
-  free_data(data, train_set, test_set);
+  free_data(data);
+  free_data(train_set);
+  free_data(test_set);
   free_mlp(mlp);
+  free(predicted);
+  free_shuffle((int *)sh);
 
   return 0;
 }
\ No newline at end of file
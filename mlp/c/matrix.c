@@ -11,6 +11,7 @@
 #include <time.h>
 #include <math.h>
 #include "matrix.h"
+#include "prof.h"
 
 #define SIGMOID(x) (1 / (1 + (exp(-(x)))))
 #define DSIGMOID(y) ((y) * (1 - (y)))
@@ -24,13 +25,15 @@
 matrix_t * mat_zinit(int rows, int cols) {
   matrix_t * mat = (matrix_t *)malloc(sizeof(*mat));
   assert(mat);
+  PROF_COUNT(PROF_MAT_ALLOC, 1);
+  PROF_COUNT(PROF_MAT_BYTES, sizeof(*mat) + rows * (sizeof(*mat->data) + cols * sizeof(**mat->data)));
 
-  mat->data = (double **)malloc(rows * sizeof(*mat->data));
+  mat->data = (ml_real_t **)malloc(rows * sizeof(*mat->data));
   assert(mat->data);
 
   int r, c;
   for(r = 0; r < rows; r++) {
-    mat->data[r] = (double *)malloc(cols * sizeof(*mat->data[r]));
+    mat->data[r] = (ml_real_t *)malloc(cols * sizeof(*mat->data[r]));
     assert(mat->data[r]);
 
     for(c = 0; c < cols; c++)
@@ -51,17 +54,19 @@ matrix_t * mat_zinit(int rows, int cols) {
 matrix_t * mat_init(int rows, int cols) {
   matrix_t * mat = (matrix_t *)malloc(sizeof(*mat));
   assert(mat);
+  PROF_COUNT(PROF_MAT_ALLOC, 1);
+  PROF_COUNT(PROF_MAT_BYTES, sizeof(*mat) + rows * (sizeof(*mat->data) + cols * sizeof(**mat->data)));
 
-  mat->data = (double **)malloc(rows * sizeof(*mat->data));
+  mat->data = (ml_real_t **)malloc(rows * sizeof(*mat->data));
   assert(mat->data);
 
   int r, c;
   for(r = 0; r < rows; r++) {
-    mat->data[r] = (double *)malloc(cols * sizeof(*mat->data[r]));
+    mat->data[r] = (ml_real_t *)malloc(cols * sizeof(*mat->data[r]));
     assert(mat->data[r]);
 
     for(c = 0; c < cols; c++) {
-      mat->data[r][c] = ((float)rand()/(float)(RAND_MAX));
+      mat->data[r][c] = rand_range(0.0, 1.0);
     }
   }
   mat->rows = rows;
@@ -75,7 +80,7 @@ matrix_t * mat_init(int rows, int cols) {
  * \param array vecteur 1D
  * \param size taille du vecteur
  */
-matrix_t * array_to_mat(double * array, int size) {
+matrix_t * array_to_mat(const ml_real_t * array, int size) {
   matrix_t * mat = mat_init(1, size);
 
   int i;
@@ -198,17 +203,21 @@ matrix_t * mat_dot(matrix_t * a, matrix_t * b) {
     exit(1);
   }
 
+  PROF_BEGIN(dot, "mat_dot");
   matrix_t * res = mat_init(a->rows, b->cols);
 
   int r, c, k;
+  double sum;
   for(r = 0; r < a->rows; r++) {
     for(c = 0; c < b->cols; c++) {
-      res->data[r][c] = 0;
+      sum = 0;
       for(k = 0; k < b->rows; k++)
-        res->data[r][c] += a->data[r][k] * b->data[k][c];
+        sum += (double)a->data[r][k] * b->data[k][c];
+      res->data[r][c] = sum;
     }
   }
 
+  PROF_END(dot);
   return res;
 }
 
@@ -12,9 +12,9 @@
 /* Structure représentant une matrice */
 typedef struct matrix matrix_t;
 struct matrix {
-  int rows;       // nombre de lignes
-  int cols;       // nombre de colonnes
-  double ** data; // données
+  int rows;          // nombre de lignes
+  int cols;          // nombre de colonnes
+  ml_real_t ** data; // données
 };
 
 matrix_t * mat_init(int, int);
@@ -28,7 +28,7 @@ matrix_t * mat_dsigmoid(matrix_t *);
 matrix_t * mat_transpose(matrix_t *);
 matrix_t * mat_dot(matrix_t *, matrix_t *);
 matrix_t * mat_reshape_col(matrix_t * a);
-matrix_t * array_to_mat(double *, int);
+matrix_t * array_to_mat(const ml_real_t *, int);
 void       mat_free(matrix_t *);
 void       mat_print(matrix_t *);
 
@@ -12,6 +12,7 @@
 #include <time.h>
 #include <math.h>
 #include "mlp.h"
+#include "prof.h"
 
  #define MAX(a,b) \
    ({ __typeof__ (a) _a = (a); \
@@ -111,16 +112,18 @@ static matrix_t ** init_weights(mlp_t * mlp, config_t * cfg) {
  * le MLP.
  *
  * \param mlp structure de la MLP
- * \param data ensemble de données
+ * \param v vecteur de la donnée
  */
-static matrix_t * forward_propagate(mlp_t * mlp, data_t data) {
-  matrix_t * act = array_to_mat(data.v, mlp->input_sz);
+static matrix_t * forward_propagate(mlp_t * mlp, const ml_real_t * v) {
+  matrix_t * act = array_to_mat(v, mlp->input_sz);
+  mat_free(mlp->act[0]);
   mlp->act[0] = act;
 
   int i;
   for(i = 0; i < mlp->n_layers - 1; i++) {
     act = mat_dot(act, mlp->w[i]);
     mat_sigmoid(act);
+    mat_free(mlp->act[i + 1]);
     mlp->act[i + 1] = act;
   }
 
@@ -128,20 +131,33 @@ static matrix_t * forward_propagate(mlp_t * mlp, data_t data) {
 }
 
 /** \brief Processus de propagation arrière pour
- * le MLP.
+ * le MLP. Les matrices intermédiaires sont libérées,
+ * ainsi que loss.
  *
  * \param mlp structure de la MLP
  * \param loss taux d'erreur de notre modèle par rapport
  * à la donnée passée
  */
 static void back_propagate(mlp_t * mlp, matrix_t * loss) {
-  matrix_t * delta = NULL;
+  matrix_t * delta = NULL, * tmp = NULL;
   int i;
   for(i = mlp->n_layers - 2; i >= 0; i--) {
-    delta = mat_mul(loss, mat_dsigmoid(mlp->act[i + 1]));
-    mlp->derivates[i] = mat_dot(mat_reshape_col(mlp->act[i]), delta);
-    loss = mat_dot(delta, mat_transpose(mlp->w[i]));
+    tmp = mat_dsigmoid(mlp->act[i + 1]);
+    delta = mat_mul(loss, tmp);
+    mat_free(tmp);
+
+    tmp = mat_reshape_col(mlp->act[i]);
+    mat_free(mlp->derivates[i]);
+    mlp->derivates[i] = mat_dot(tmp, delta);
+    mat_free(tmp);
+
+    tmp = mat_transpose(mlp->w[i]);
+    mat_free(loss);
+    loss = mat_dot(delta, tmp);
+    mat_free(tmp);
+    mat_free(delta);
   }
+  mat_free(loss);
 }
 
 /** \brief Applique l'algorithme du gradient
@@ -188,52 +204,61 @@ mlp_t * init_mlp(config_t * cfg) {
  * \param cfg données de configuration
  */
 void train(mlp_t * mlp, data_t * train_set, config_t * cfg) {
-  int i, it, 
-      train_sz = cfg->data_sz - (int)(cfg->data_sz * cfg->test_size);
+  PROF_BEGIN(train, "train");
+  int i, it, train_sz = train_set->n;
 
   matrix_t * output, * loss;
 
   for(it = 0; it < cfg->n_iters; it++) {
     for(i = 0; i < train_sz; i++) {
-      output = forward_propagate(mlp, train_set[i]);
-      loss = mat_sub(output, train_set[i].target);
+      output = forward_propagate(mlp, DATA_ROW(train_set, i));
+      loss = mat_sub(output, train_set->label[i]);
       back_propagate(mlp, loss);
       gradient_descent(mlp);
     }
   }
+  PROF_END(train);
 }
 
 /** \brief Prédire les données tests grâce au MLP
  * entraîné.
  *
  * \param mlp structure de MLP
- * \param data ensemble de données
  * \param test données tests
  * \param cfg données de configuration
+ *
+ * \return la classe prédite pour chaque donnée test
  */
-void predict(mlp_t * mlp, data_t * data, data_t * test, config_t * cfg) {
+int * predict(mlp_t * mlp, data_t * test, config_t * cfg) {
+  PROF_BEGIN(predict, "predict");
   matrix_t * output = NULL;
   int i;
 
-  for(i = 0; i < (int)(cfg->data_sz * cfg->test_size); i++) {  
-    output = forward_propagate(mlp, test[i]);
-    test[i].target = get_target(output);
+  int * predicted = (int *)malloc(test->n * sizeof(*predicted));
+  assert(predicted);
+
+  for(i = 0; i < test->n; i++) {  
+    output = forward_propagate(mlp, DATA_ROW(test, i));
+    predicted[i] = get_target(output);
   }
+
+  PROF_END(predict);
+  return predicted;
 }
 
 /** \brief Calcule de l'erreur quadratique moyenne.
  *
  * \param mlp structure de MLP
- * \param data ensemble de données
  * \param test données tests
+ * \param predicted classes prédites
  * \param cfg données de configuration
  */
-double mse(mlp_t * mlp, data_t * data, data_t * test, config_t * cfg) {
-  int i, test_sz = (int)(cfg->data_sz * cfg->test_size);
+double mse(mlp_t * mlp, data_t * test, int * predicted, config_t * cfg) {
+  int i, test_sz = test->n;
   double errors = 0.0;
 
   for(i = 0; i < test_sz; i++)
-    errors += data[test[i].index].target - test[i].target;
+    errors += test->label[i] - predicted[i];
 
   return pow(errors, 2.0) / test_sz;
 }
@@ -244,6 +269,17 @@ double mse(mlp_t * mlp, data_t * data, data_t * test, config_t * cfg) {
  */
 void free_mlp(mlp_t * mlp) {
   if(mlp) {
+    int i;
+    for(i = 0; i < mlp->n_layers - 1; i++) {
+      mat_free(mlp->w[i]);
+      mat_free(mlp->derivates[i]);
+    }
+    for(i = 0; i < mlp->n_layers; i++)
+      mat_free(mlp->act[i]);
+    free(mlp->w);
+    free(mlp->derivates);
+    free(mlp->act);
+    free(mlp->layers);
     free(mlp);
     mlp = NULL;
   }
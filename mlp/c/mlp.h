@@ -26,8 +26,8 @@ struct mlp {
 
 mlp_t * init_mlp(config_t *);
 void    train(mlp_t *, data_t *, config_t *);
-void    predict(mlp_t *, data_t *, data_t *, config_t *);
-double  mse(mlp_t *, data_t *, data_t *, config_t *);
+int *   predict(mlp_t *, data_t *, config_t *);
+double  mse(mlp_t *, data_t *, int *, config_t *);
 void    free_mlp(mlp_t * mlp);
 
 #endif
\ No newline at end of file
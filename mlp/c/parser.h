@@ -6,30 +6,18 @@
 #ifndef _PARSER_H_
 #define _PARSER_H_
 
+#include "data.h"
+#include "rng.h"
 #include "config.h"
 
-/** \brief Structure représentant les données */
-typedef struct data data_t;
-struct data {
-  double * v;   // vecteur de données
-  int index;    // index dans la bdd
-  char * label; // étiquette
-  int target;   // étiquette sous la forme de int
-  double norm;  // norme
-};
-
 data_t *   read_file(char *, config_t *);
-void       normalize(data_t *, config_t *);
-config_t * init_config(char *);
-data_t *   train_split(data_t *, const int *, config_t *);
 data_t *   test_split(data_t *, const int *, config_t *);
-int *      init_shuffle(int);
+data_t *   train_split(data_t *, const int *, config_t *);
+config_t * init_config(char *);
 void       free_config(config_t *);
-void       free_data(data_t *, data_t *, data_t *);
 
 #ifdef DEBUG
-void       print_data(data_t *, config_t *);
 void       print_config(config_t *);
 #endif
 
-#endif
\ No newline at end of file
+#endif
@@ -26,23 +26,24 @@ int main(int argc, char *argv[]) {
 
   cfg = init_config(CONFIG_FILE);
   data = read_file(argv[1], cfg);
-  normalize(data, cfg);
+  normalize(data);
   int * sh = init_shuffle(cfg->data_sz);
   net = init_network(data, cfg);
 
   train(net, sh, data, cfg);
   label(net, data, cfg);
-  print_map(net, cfg);
+  print_map(net, data, cfg);
 
 #ifdef DEBUG
   print_config(cfg);
   print_shuffle(sh, cfg->data_sz);
   print_net(net, cfg);
-  print_data(data, cfg);
+  print_data(data);
 #endif
 
   free_config(cfg);
   free_data(data);
   free_network(net);
+  free_shuffle(sh);
   return 0;
 }
\ No newline at end of file
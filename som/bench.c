@@ -0,0 +1,60 @@
+/*!
+ * \file bench.c
+ * \brief Fichier principale concernant la mesure des
+ * performances de SOM: chargement, initialisation,
+ * apprentissage et étiquetage, répétés dans le même processus.
+ * \author PANCHALINGAMOORTHY Gajenthran
+ */
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "bench.h"
+#include "som.h"
+#include "parser.h"
+#include "config.h"
+
+int main(int argc, char *argv[]) {
+  int reps, r;
+  char * json = NULL;
+  char * filename = bench_args(argc, argv, &reps, &json);
+
+  config_t * cfg = init_config(CONFIG_FILE);
+  bench_t * b = init_bench("som", filename, reps);
+
+  for(r = 0; r < reps; r++) {
+    // mêmes tirages aléatoires à chaque répétition
+    init_rng(cfg->seed);
+
+    bench_start(b);
+    data_t * data = read_file(filename, cfg);
+    bench_stop(b, "load", data->n);
+
+    bench_start(b);
+    normalize(data);
+    int * sh = init_shuffle(cfg->data_sz);
+    network_t * net = init_network(data, cfg);
+    bench_stop(b, "init", data->n);
+
+    bench_start(b);
+    train(net, sh, data, cfg);
+    bench_stop(b, "train", data->n);
+
+    bench_start(b);
+    label(net, data, cfg);
+    bench_stop(b, "label", data->n);
+
+    b->rows = data->n;
+    b->dims = data->d;
+    free_network(net);
+    free_shuffle(sh);
+    free_data(data);
+  }
+
+  print_bench(b);
+  if(json)
+    write_bench_json(b, json);
+
+  free_bench(b);
+  free_config(cfg);
+  return 0;
+}
@@ -24,6 +24,7 @@ struct config {
   double w_avg_max; // interval max pour w
   float margin_err; // marge d'erreur
   float ph_1, ph_2; // phase 1 et phase 2 (rapport de la phase pour les itérations)
+  unsigned long long seed; // graine des tirages aléatoires (0: aléatoire)
 };
 
 #endif
\ No newline at end of file
@@ -29,8 +29,7 @@ list_t * init_list(void) {
  * \return bmu (best match unit)
  */
 bmu_t get_bmu_from_list(list_t * l) {
-  srand(time(NULL));
-  int r = (rand() % l->size), it = 0;
+  int r = rand_int(l->size), it = 0;
   lnode_t * n;
   while(l->head) {
     n = l->head;
@@ -15,48 +15,14 @@
 #include "som.h"
 #include "ll.h"
 
-#define RED   "\x1B[31m"
-#define GREEN "\x1B[32m"
-#define BLUE  "\x1B[34m"
-#define WHITE "\x1B[37m"
-#define RESET "\x1B[0m"
-
-/** \brief Initialise le vecteur représentant l'ordre
- * de passage des données lors de la phase d'apprentissage
- *
- * \param size nombre de données
- *
- * \return vecteur représentant l'ordre de passage des données.
- */
-int * init_shuffle(int size) {
-  srand(time(NULL));
-  int i;
-  int * sh = (int *)malloc(size * sizeof(*sh));
-  assert(sh);
-
-  for(i = 0; i < size; i++)
-    sh[i] = i;
-  shuffle(sh, size);
-  return sh;
-}
-
-/** \brief Mélange le vecteur représentant l'ordre de passage des données
- * lors de la phase d'apprentissage
- *
- * \param sh   vecteur représentant l'ordre de passage des données
- * \param size taille du vecteur
- */
-void shuffle(int * sh, int size) {
-  int i, r;
-  for(i = 0; i < size; i++) {
-    r = rand() % size;
-    if(sh[i] != sh[r]) {
-      sh[i] ^= sh[r];
-      sh[r] ^= sh[i];
-      sh[i] ^= sh[r];
-    }
-  }
-}
+#define RED     "\x1B[31m"
+#define GREEN   "\x1B[32m"
+#define YELLOW  "\x1B[33m"
+#define BLUE    "\x1B[34m"
+#define MAGENTA "\x1B[35m"
+#define CYAN    "\x1B[36m"
+#define WHITE   "\x1B[37m"
+#define RESET   "\x1B[0m"
 
 /** \brief Initialise le réseau de neurones à partir des
  * des données de la bd, en initialisant le coefficient
@@ -78,17 +44,22 @@ network_t * init_network(data_t * data, config_t *cfg) {
   net->map = (node_t **)malloc(cfg->map_l * sizeof(*net->map));
   assert(net->map);
 
+  // poids de tous les neurones dans un unique bloc aligné
+  net->stride = data->stride;
+  if(posix_memalign((void **)&net->w, DATA_ALIGN,
+      (size_t)cfg->map_l * cfg->map_c * net->stride * sizeof(*net->w))) {
+    fprintf(stderr, "Can't allocate %d x %d map\n", cfg->map_l, cfg->map_c);
+    exit(1);
+  }
+  memset(net->w, 0, (size_t)cfg->map_l * cfg->map_c * net->stride * sizeof(*net->w));
+
   for(l = 0; l < cfg->map_l; l++) {
     net->map[l] = (node_t *)malloc(cfg->map_c * sizeof(*net->map[l]));
     assert(net->map[l]);
 
     for(c = 0; c < cfg->map_c; c++) {
-      for(i = 0; i < cfg->nb_val; i++) {
-        net->map[l][c].w = (double *)malloc(cfg->nb_val * sizeof(*net->map[l][c].w));
-        assert(net->map[l][c].w);
-      }
-
-      net->map[l][c].freq = (int *)calloc(0, cfg->nb_label * sizeof(*net->map[l][c].freq));
+      net->map[l][c].w = net->w + ((size_t)l * cfg->map_c + c) * net->stride;
+      net->map[l][c].freq = (int *)calloc(cfg->nb_label, sizeof(*net->map[l][c].freq));
       assert(net->map[l][c].freq);
     }
   }
@@ -96,12 +67,12 @@ network_t * init_network(data_t * data, config_t *cfg) {
   for(i = 0; i < cfg->nb_val; i++) {
     sum = 0;
     for(j = 0; j < cfg->data_sz; j++)
-      sum += data[j].v[i];
+      sum += DATA_ROW(data, j)[i];
     avg = sum / cfg->data_sz;
 
     for(l = 0; l < cfg->map_l; l++)
       for(c = 0; c < cfg->map_c; c++) {
-        net->map[l][c].w[i] = my_rand(avg - cfg->w_avg_min, avg + cfg->w_avg_max);
+        net->map[l][c].w[i] = rand_range(avg - cfg->w_avg_min, avg + cfg->w_avg_max);
       }
   }
 
@@ -121,10 +92,10 @@ network_t * init_network(data_t * data, config_t *cfg) {
  * \param cfg  données de configuration
  */
 void train(network_t * net, int * sh, data_t * data, config_t *cfg) {
+  PROF_BEGIN(train, "train");
   bmu_t bmu;
-  int i, l, it, iterations;
+  int i, it, iterations;
   double ph;
-  const char * label[] = {"Iris-setosa", "Iris-versicolor", "Iris-virginica"};
   for(ph = cfg->ph_1; ph < 1.0; ph += (cfg->ph_2 - cfg->ph_1)) {
     // nombre d'itérations
     iterations = cfg->iter * ph;
@@ -134,20 +105,16 @@ void train(network_t * net, int * sh, data_t * data, config_t *cfg) {
       shuffle(sh, cfg->data_sz);
       // pour tout i appartenant aux données v de la bd
       for(i = 0; i < cfg->data_sz; i++) {
-        bmu = find_bmu(net, data[sh[i]].v, cfg);
-        apply_nhd(net, data[sh[i]].v, bmu, cfg);
-
-        for(l = 0; l < cfg->nb_label; l++) {
-          if(!strcmp(label[l], data[sh[i]].label)) {
-            net->map[bmu.l][bmu.c].freq[l]++;
-          }
-        }
+        bmu = find_bmu(net, DATA_ROW(data, sh[i]), cfg);
+        apply_nhd(net, DATA_ROW(data, sh[i]), bmu, cfg);
+        net->map[bmu.l][bmu.c].freq[data->label[sh[i]]]++;
       }
 
       net->nhd_rad = cfg->nhd_rad * exp(-(double)it / (double)iterations);
       net->alpha = cfg->alpha * (1.0 - ((double)it / (double)iterations));
     }
   }
+  PROF_END(train);
 }
 
 /** \brief Etiqueter les données après la phase d'apprentissage.
@@ -157,37 +124,40 @@ void train(network_t * net, int * sh, data_t * data, config_t *cfg) {
  * \param cfg  données de configuration
  */
 void label(network_t * net, data_t * data, config_t *cfg) {
+  PROF_BEGIN(label, "label");
   int l, c, i;
   bmu_t bmu;
   double dist;
 
   for(l = 0; l < cfg->map_l; l++) {
     for(c = 0; c < cfg->map_c; c++) {
-      bmu.act = euclidean_dist(net->map[l][c].w, data[0].v, cfg->nb_val);
+      bmu.act = sq_l2_dist(net->map[l][c].w, DATA_ROW(data, 0), cfg->nb_val);
       bmu.l = 0;
       for(i = 0; i < cfg->data_sz; i++) {
-        dist = euclidean_dist(net->map[l][c].w, data[i].v, cfg->nb_val);
-        if(bmu.act > dist) {
+        dist = sq_l2_dist(net->map[l][c].w, DATA_ROW(data, i), cfg->nb_val);
+        if(sq_dist_cmp(bmu.act, dist) > 0) {
           bmu.act = dist;
           bmu.l = i;
         }
       }
 
       // vérifie si le neurone sélectionné n'oscille pas entre deux classes
-      int sum = net->map[l][c].freq[0] + net->map[l][c].freq[1] + net->map[l][c].freq[2];
-      int find = 0;
+      int sum = 0;
+      for(i = 0; i < cfg->nb_label; i++)
+        sum += net->map[l][c].freq[i];
+
+      net->map[l][c].label = -1;
       for(i = 0; i < cfg->nb_label; i++) {
         if(net->map[l][c].freq[i] * 100 / (double)sum > cfg->margin_err) {
-          net->map[l][c].label = strdup(data[bmu.l].label);
-          find = 1;
+          net->map[l][c].label = data->label[bmu.l];
           break;
         }
       }
 
-      if(!find) { net->map[l][c].label = strdup("not_find"); }
-      net->map[l][c].act = bmu.act;
+      net->map[l][c].act = sqrt(bmu.act);
     }
   }
+  PROF_END(label);
 }
 
 /** \brief Applique la règle d'apprentissage selon aux voisins
@@ -201,7 +171,8 @@ void label(network_t * net, data_t * data, config_t *cfg) {
  * \param bmu structure représentant le bmu (best match unit)
  * \param cfg données de configuration
  */
-void apply_nhd(network_t * net, double * v, bmu_t bmu, config_t *cfg) {
+void apply_nhd(network_t * net, const ml_real_t * v, bmu_t bmu, config_t *cfg) {
+  PROF_BEGIN(nhd, "apply_nhd");
   int i, l, c, l0, c0;
   // pour tout node l, c appartenant à Nhd(i)
   for(l = -net->nhd_rad; l <= net->nhd_rad; l++) {
@@ -217,6 +188,7 @@ void apply_nhd(network_t * net, double * v, bmu_t bmu, config_t *cfg) {
       }
     }
   }
+  PROF_END(nhd);
 }
 
 /** \brief Trouver le bmu (best match unit) en comparant les
@@ -226,26 +198,28 @@ void apply_nhd(network_t * net, double * v, bmu_t bmu, config_t *cfg) {
  * \param v   vecteur de données
  * \param cfg données de configuration
  *
- * \return structure réprésentant le bmu (best match unit)
+ * \return structure réprésentant le bmu (best match unit), la recherche
+ * comparant les distances au carré
  */
-
-bmu_t find_bmu(network_t * net, double * v, config_t *cfg) {
+bmu_t find_bmu(network_t * net, const ml_real_t * v, config_t *cfg) {
+  PROF_BEGIN(find, "find_bmu");
+  PROF_COUNT(PROF_BMU, 1);
   int l, c;
   double dist;
   list_t * bmu_lis = init_list();
-  bmu_t bmu = {euclidean_dist(v, net->map[0][0].w, cfg->nb_val), 0, 0};
+  bmu_t bmu = {sq_l2_dist(v, net->map[0][0].w, cfg->nb_val), 0, 0};
   insert_list(bmu_lis, bmu);
   for(l = 0; l < cfg->map_l; l++) {
     for(c = 0; c < cfg->map_c; c++) {
-      dist = euclidean_dist(v, net->map[l][c].w, cfg->nb_val);
+      dist = sq_l2_dist(v, net->map[l][c].w, cfg->nb_val);
 
-      if(bmu.act > dist) {
+      if(sq_dist_cmp(bmu.act, dist) > 0) {
         bmu.act = dist;
         bmu.l = l; bmu.c = c;
         modify_list(bmu_lis, bmu);
       }
 
-      if(bmu.act == dist) {
+      if(!sq_dist_cmp(bmu.act, dist)) {
         bmu.l = l; bmu.c = c;
         insert_list(bmu_lis, bmu);
       }
@@ -253,56 +227,32 @@ bmu_t find_bmu(network_t * net, double * v, config_t *cfg) {
   }
 
   bmu = get_bmu_from_list(bmu_lis);
+  bmu.act = sqrt(bmu.act);
   free_list(bmu_lis);
+  PROF_END(find);
   return bmu;
 }
 
-/** \brief Calcule la distance euclidienne de deux vecteurs
- *
- * \param v vecteur v
- * \param w vecteur w
- * \param size taille des vecteurs v et w (partageant la même taille)
- *
- * \return la distance de l'ensemble des deux vecteurs.
- */
-double euclidean_dist(double * v, double * w, int size) {
-  double sum = 0;
-  int i;
-  for(i = 0; i < size; i++)
-    sum += pow(v[i] - w[i], 2.0);
-  return sqrt(sum);
-}
-
-/** \brief Fonction retournant un nombre aléatoire entre deux
- * intervalles.
- *
- * \param min interval minimal
- * \param max interval maximal
- *
- * \return Nombre aléatoire entre les intervalles min-max.
- */
-double my_rand(double min, double max) {
-  return (rand()/(double)RAND_MAX) * (max - min) + min;
-}
-
 /** \brief Affiche la map avec les neurones étiquetés.
  *
  * \param net réseau de neurones
+ * \param data données
  * \param cfg données de configuration
  */
-void print_map(network_t * net, config_t * cfg) {
-  int l, c;
-  printf("Iris-setosa:     "); printf(RED   " o \n"     RESET);
-  printf("Iris-versicolor: "); printf(BLUE  " o \n"     RESET);
-  printf("Iris-virginica:  "); printf(GREEN " o \n\n"     RESET);
+void print_map(network_t * net, data_t * data, config_t * cfg) {
+  const char * colors[] = {RED, BLUE, GREEN, YELLOW, MAGENTA, CYAN};
+  const int nb_colors = sizeof(colors) / sizeof(*colors);
+  int l, c, id;
+
+  for(id = 0; id < cfg->nb_label; id++)
+    printf("%-16s %s o \n" RESET, data->labels->names[id], colors[id % nb_colors]);
+  printf("\n");
+
   for(l = 0; l < cfg->map_l; l++) {
     for(c = 0; c < cfg->map_c; c++) {
-      if(!strcmp(net->map[l][c].label, "Iris-setosa")) {
-        printf(RED " o " RESET);
-      } else if(!strcmp(net->map[l][c].label, "Iris-versicolor")) {
-        printf(BLUE " o " RESET);
-      } else if(!strcmp(net->map[l][c].label, "Iris-virginica")) {
-        printf(GREEN " o " RESET);
+      id = net->map[l][c].label;
+      if(id >= 0) {
+        printf("%s o " RESET, colors[id % nb_colors]);
       } else {
         printf(WHITE " x " RESET);
       }
@@ -312,23 +262,13 @@ void print_map(network_t * net, config_t * cfg) {
   printf("\n");
 }
 
-/** \brief Libère la mémoire pour le shuffle.
- *
- * \param sh vecteur représentant l'ordre de passage des données
- */
-void free_shuffle(int *sh) {
-  if(sh) {
-    free(sh);
-    sh = NULL;
-  }
-}
-
 /** \brief Libère la mémoire pour le réseau de neurones.
  *
  * \param net réseau de neurones
  */
 void free_network(network_t *net) {
   if(net) {
+    free(net->w);
     free(net);
     net = NULL;
   }